@@ -4,20 +4,31 @@
 #
 #-------------------------------------------------
 
-QT       += core gui
+QT       += core gui network concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
+CONFIG += c++11 thread
+
 TARGET = OrbitPixelParamsCalc
 TEMPLATE = app
 
 
 SOURCES += main.cpp\
         mainwindow.cpp \
-    orbitpixparams.cpp
+    orbitpixparams.cpp \
+    orbitpixcalc.cpp \
+    calcserver.cpp \
+    demterrain.cpp \
+    sweepspec.cpp
 
 HEADERS  += mainwindow.h \
-    orbitpixparams.h
+    orbitpixparams.h \
+    orbitpixcalc.h \
+    dualnum.h \
+    calcserver.h \
+    demterrain.h \
+    sweepspec.h
 
 FORMS    += mainwindow.ui
 
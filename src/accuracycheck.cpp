@@ -0,0 +1,317 @@
+#include "accuracycheck.h"
+#include <math.h>
+#define PI 3.141592653589793
+
+//-----------------------------------------------------------------------------
+// HIGH-PRECISION REFERENCE:
+//-----------------------------------------------------------------------------
+
+// The reference uses long double and a different (numerically stable) formulation from OrbitPixParams:
+// the line of sight is the nearest root of the ray-sphere intersection and the pixel size is the difference
+// of the central angles of the pixel sides (times r).
+
+// Line of sight for a ray at angle ang from nadir
+static long double refLos(long double ang, long double r, long double h)
+{
+    long double s = (r + h) * sinl(ang);
+
+    return h * (2 * r + h) / ((r + h) * cosl(ang) + sqrtl(r * r - s * s));
+}
+
+// Central angle (planet centre) between the satellite and the ground point of a ray at angle ang from nadir
+static long double refCentralAng(long double ang, long double r, long double h)
+{
+    return asinl((r + h) * sinl(ang) / r) - ang;
+}
+
+//-----------------------------------------------------------------------------
+// CHECK:
+//-----------------------------------------------------------------------------
+
+// Distance to the next representable double (units in the last place)
+static double ulp(double x)
+{
+    x = fabs(x);
+
+    return nextafter(x, INFINITY) - x;
+}
+
+static string configStr(double h, double fov, double viewAng, double r, int px, int i)
+{
+    char buf[160];
+
+    snprintf(buf, sizeof(buf), "h=%g fov=%.17g viewAng=%.17g r=%g px=%d pixel=%d", h, fov, viewAng, r, px, i + 1);
+
+    return string(buf);
+}
+
+// With a (flat) DEM the pixel size is the straight distance between the terrain points of the pixel sides
+static void checkConfig(double h, double fov, double viewAng, double r, int px, const DemTerrain *dem, double tol,
+                        AccuracyReport &report)
+{
+    OrbitPixParams orbitPixParamsObj(h, fov, viewAng, r, px);
+    vector<double> angVec, losVec, pixVec;
+    double dViewAng = fov / px;
+    double losErr, pixErr, losUlp, pixUlp;
+    long double los, pix, cAng_1, cAng_2;
+    AccuracyErrs &errs = dem ? report.flatDem : report.sphere;
+    bool failed = false;
+
+    orbitPixParamsObj.setDem(dem);
+    orbitPixParamsObj.losCalc();
+    orbitPixParamsObj.pixSizeCalc();
+    if (orbitPixParamsObj.getErr())
+        return; // out of the valid domain
+
+    angVec = orbitPixParamsObj.getAngVec();
+    losVec = orbitPixParamsObj.getLosVec();
+    pixVec = orbitPixParamsObj.getPixVec();
+    report.nConfigs++;
+
+    // the sides of the pixel angles use the same (double) angles as OrbitPixParams
+    cAng_1 = refCentralAng(viewAng + fov / 2, r, h);
+    for (int i = 0; i < px; i++)
+    {
+        cAng_2 = refCentralAng(viewAng + fov / 2 - (i + 1) * dViewAng, r, h);
+        los = refLos(angVec[i], r, h);
+        pix = dem ? 2 * r * sinl(fabsl(cAng_1 - cAng_2) / 2) : r * fabsl(cAng_1 - cAng_2);
+        cAng_1 = cAng_2;
+
+        losErr = 1000 * fabs(losVec[i] - (double)los);
+        pixErr = 1000 * fabs(pixVec[i] - (double)pix);
+        losUlp = fabs(losVec[i] - (double)los) / ulp((double)los);
+        pixUlp = fabs(pixVec[i] - (double)pix) / ulp((double)pix);
+
+        if (!isfinite(losVec[i]) || !isfinite(pixVec[i]) || losErr > tol || pixErr > tol)
+            failed = true;
+
+        if (!(losErr <= errs.maxLosErr)) // also catches NaN
+        {
+            errs.maxLosErr = losErr;
+            errs.maxLosUlp = losUlp;
+            errs.worstLos = configStr(h, fov, viewAng, r, px, i);
+        }
+        if (!(pixErr <= errs.maxPixErr))
+        {
+            errs.maxPixErr = pixErr;
+            errs.maxPixUlp = pixUlp;
+            errs.worstPix = configStr(h, fov, viewAng, r, px, i);
+        }
+    }
+
+    if (failed)
+        report.nFailed++;
+}
+
+AccuracyReport accuracyCheck(double tol)
+{
+    const double hVals[] = {200, 550, 1000, 20200, 35786};
+    const double rVals[] = {1737.4, 3389.5, 6371};
+    const double fovFracs[] = {1e-4, 0.01, 0.1, 0.5, 0.9, 0.999}; // of the max fov
+    const double angFracs[] = {-0.9999, -0.5, 0, 0.5, 0.9999}; // of the max view angle
+    const int pxVals[] = {1, 2, 3, 640, 641, 4096};
+    AccuracyReport report;
+    DemTerrain flatDem;
+    double maxFov, fov;
+
+    report.nConfigs = 0;
+    report.nFailed = 0;
+    report.sphere.maxLosErr = report.sphere.maxPixErr = 0;
+    report.sphere.maxLosUlp = report.sphere.maxPixUlp = 0;
+    report.flatDem = report.sphere;
+
+    for (size_t ih = 0; ih < sizeof(hVals) / sizeof(hVals[0]); ih++)
+        for (size_t ir = 0; ir < sizeof(rVals) / sizeof(rVals[0]); ir++)
+        {
+            OrbitPixParams probe(hVals[ih], 0, 0, rVals[ir], 1);
+            maxFov = probe.getMaxFov();
+
+            for (size_t ifov = 0; ifov < sizeof(fovFracs) / sizeof(fovFracs[0]); ifov++)
+            {
+                fov = fovFracs[ifov] * maxFov;
+                for (size_t iang = 0; iang < sizeof(angFracs) / sizeof(angFracs[0]); iang++)
+                    for (size_t ipx = 0; ipx < sizeof(pxVals) / sizeof(pxVals[0]); ipx++)
+                        checkConfig(hVals[ih], fov, angFracs[iang] * (maxFov / 2 - fov / 2), rVals[ir], pxVals[ipx], NULL, tol,
+                                    report);
+
+                // a pixel side exactly at nadir (ang_1 == 0), when the view angle fov / 2 is not beyond the horizon
+                if (fovFracs[ifov] < 0.5)
+                {
+                    checkConfig(hVals[ih], fov, fov / 2, rVals[ir], 64, NULL, tol, report);
+                    checkConfig(hVals[ih], fov, -fov / 2, rVals[ir], 64, NULL, tol, report);
+                }
+            }
+        }
+
+    // A flat (all-zero) DEM must give the sphere: covers the terrain intersection, near nadir too
+    flatDem.loadProfile(vector<float>(200001, 0.0f), -PI / 2, PI / 200000);
+    for (size_t ih = 0; ih < sizeof(hVals) / sizeof(hVals[0]); ih++)
+    {
+        maxFov = orbitPixMaxFov(hVals[ih], 6371);
+        for (size_t ifov = 1; ifov < 4; ifov++)
+        {
+            fov = fovFracs[ifov] * maxFov;
+            for (size_t iang = 0; iang < sizeof(angFracs) / sizeof(angFracs[0]); iang++)
+                checkConfig(hVals[ih], fov, angFracs[iang] * (maxFov / 2 - fov / 2), 6371, 641, &flatDem, tol, report);
+            if (fovFracs[ifov] < 0.5) // a side exactly at the horizon is tangent to the terrain: ill-conditioned
+                checkConfig(hVals[ih], fov, fov / 2, 6371, 64, &flatDem, tol, report);
+        }
+    }
+    checkConfig(550, 0.3, 0.05, 6371, 2000, &flatDem, tol, report); // pixels a few 1e-5 rad from nadir
+
+    return report;
+}
+
+static void printAccuracyErrs(FILE *f, const char *terrain, const AccuracyErrs &errs)
+{
+    fprintf(f, "%s LoS max error:  %.3e m (%.1f ulp) at %s\n", terrain, errs.maxLosErr, errs.maxLosUlp,
+            errs.worstLos.c_str());
+    fprintf(f, "%s size max error: %.3e m (%.1f ulp) at %s\n", terrain, errs.maxPixErr, errs.maxPixUlp,
+            errs.worstPix.c_str());
+}
+
+void printAccuracyReport(FILE *f, const AccuracyReport &report)
+{
+    fprintf(f, "Configurations checked: %d, failed: %d\n", report.nConfigs, report.nFailed);
+    printAccuracyErrs(f, "Sphere", report.sphere);
+    printAccuracyErrs(f, "Flat DEM", report.flatDem);
+}
+
+//-----------------------------------------------------------------------------
+// SENSITIVITY CHECK:
+//-----------------------------------------------------------------------------
+
+static const char *sensNames[] = {"h", "fov", "viewAng", "r"};
+
+// Input with the parameter k changed by delta
+static OrbitPixInput sensInput(const OrbitPixInput &in, int k, double delta)
+{
+    OrbitPixInput out = in;
+
+    if (k == SENS_H)
+        out.h += delta;
+    else if (k == SENS_FOV)
+        out.fov += delta;
+    else if (k == SENS_VIEWANG)
+        out.viewAng += delta;
+    else
+        out.r += delta;
+
+    return out;
+}
+
+// Max error of the derivatives dVec against the central differences (vecPlus - vecMinus) / (2 delta), relative to the
+// max derivative of the configuration, but at least to max(vec) / scale: some derivatives are 0 or negligible (e.g. of
+// the pixel size near nadir w.r.t. the radius), and then the finite differences are only rounding noise.
+static double sensErr(const vector<double> &dVec, const vector<double> &vec, const vector<double> &vecPlus,
+                      const vector<double> &vecMinus, double delta, double scale, int *iWorst)
+{
+    double maxD = 0, maxErr = 0, fd;
+
+    for (size_t i = 0; i < dVec.size(); i++)
+    {
+        maxD = fabs(dVec[i]) > maxD ? fabs(dVec[i]) : maxD;
+        maxD = fabs(vec[i]) / scale > maxD ? fabs(vec[i]) / scale : maxD;
+    }
+
+    for (size_t i = 0; i < dVec.size(); i++)
+    {
+        fd = (vecPlus[i] - vecMinus[i]) / (2 * delta);
+        if (!(fabs(dVec[i] - fd) <= maxErr)) // also catches NaN
+        {
+            maxErr = fabs(dVec[i] - fd);
+            *iWorst = i;
+        }
+    }
+
+    return maxD > 0 ? maxErr / maxD : maxErr;
+}
+
+static void checkSensConfig(double h, double fov, double viewAng, double r, int px, double tol, SensReport &report)
+{
+    OrbitPixInput in = orbitPixInput(h, fov, viewAng, r, px);
+    OrbitPixResult res = orbitPixCalc(in, CALC_SENS), plus, minus;
+    double scale[SENS_NPARAMS] = {h, fov, fov, r}; // the results change on about these scales
+    double delta, losErr, pixErr;
+    int iLos = 0, iPix = 0;
+    bool failed = false;
+
+    if (res.err != ERR_NONE)
+        return; // out of the valid domain
+    report.nConfigs++;
+
+    for (int k = 0; k < SENS_NPARAMS; k++)
+    {
+        delta = 1e-5 * scale[k];
+        plus = orbitPixCalc(sensInput(in, k, delta));
+        minus = orbitPixCalc(sensInput(in, k, -delta));
+        if (plus.err != ERR_NONE || minus.err != ERR_NONE)
+            continue; // at the limit of the valid domain
+
+        losErr = sensErr(res.losSensVec[k], res.losVec, plus.losVec, minus.losVec, delta, scale[k], &iLos);
+        pixErr = sensErr(res.pixSensVec[k], res.pixVec, plus.pixVec, minus.pixVec, delta, scale[k], &iPix);
+        if (!(losErr <= tol) || !(pixErr <= tol))
+            failed = true;
+
+        if (!(losErr <= report.maxLosErr[k]))
+        {
+            report.maxLosErr[k] = losErr;
+            report.worstLos[k] = configStr(h, fov, viewAng, r, px, iLos);
+        }
+        if (!(pixErr <= report.maxPixErr[k]))
+        {
+            report.maxPixErr[k] = pixErr;
+            report.worstPix[k] = configStr(h, fov, viewAng, r, px, iPix);
+        }
+    }
+
+    if (failed)
+        report.nFailed++;
+}
+
+SensReport sensCheck(double tol)
+{
+    const double hVals[] = {200, 550, 35786};
+    const double rVals[] = {1737.4, 6371};
+    const double fovFracs[] = {0.01, 0.1, 0.5}; // of the max fov
+    const double angFracs[] = {-0.9, -0.5, 0, 0.5, 0.9}; // of the max view angle
+    const int pxVals[] = {1, 3, 64};
+    SensReport report;
+    double maxFov, fov;
+
+    report.nConfigs = 0;
+    report.nFailed = 0;
+    for (int k = 0; k < SENS_NPARAMS; k++)
+        report.maxLosErr[k] = report.maxPixErr[k] = 0;
+
+    for (size_t ih = 0; ih < sizeof(hVals) / sizeof(hVals[0]); ih++)
+        for (size_t ir = 0; ir < sizeof(rVals) / sizeof(rVals[0]); ir++)
+        {
+            maxFov = orbitPixMaxFov(hVals[ih], rVals[ir]);
+            for (size_t ifov = 0; ifov < sizeof(fovFracs) / sizeof(fovFracs[0]); ifov++)
+            {
+                fov = fovFracs[ifov] * maxFov;
+                for (size_t iang = 0; iang < sizeof(angFracs) / sizeof(angFracs[0]); iang++)
+                    for (size_t ipx = 0; ipx < sizeof(pxVals) / sizeof(pxVals[0]); ipx++)
+                        checkSensConfig(hVals[ih], fov, angFracs[iang] * (maxFov / 2 - fov / 2), rVals[ir], pxVals[ipx],
+                                        tol, report);
+
+                checkSensConfig(hVals[ih], fov, fov / 2, rVals[ir], 64, tol, report); // a pixel side at nadir
+                checkSensConfig(hVals[ih], fov, 0, rVals[ir], 65, tol, report); // the centre of a pixel at nadir
+            }
+        }
+
+    return report;
+}
+
+void printSensReport(FILE *f, const SensReport &report)
+{
+    fprintf(f, "Sensitivity configurations checked: %d, failed: %d\n", report.nConfigs, report.nFailed);
+    for (int k = 0; k < SENS_NPARAMS; k++)
+    {
+        fprintf(f, "d/d%s LoS max rel. error:  %.3e at %s\n", sensNames[k], report.maxLosErr[k],
+                report.worstLos[k].c_str());
+        fprintf(f, "d/d%s size max rel. error: %.3e at %s\n", sensNames[k], report.maxPixErr[k],
+                report.worstPix[k].c_str());
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef AccuracyCheck_H
+#define AccuracyCheck_H
+
+#include <stdio.h>
+#include <string>
+#include "orbitpixparams.h"
+
+using namespace std;
+
+// Worst errors of one kind of terrain
+struct AccuracyErrs
+{
+    double maxLosErr, maxPixErr; // max absolute error (m)
+
+    double maxLosUlp, maxPixUlp; // max error in units in the last place (of double)
+
+    string worstLos, worstPix; // configurations of the max errors
+};
+
+// Worst errors of OrbitPixParams (losCalc() and pixSizeCalc()) against the high-precision reference
+struct AccuracyReport
+{
+    int nConfigs; // number of configurations checked
+
+    int nFailed; // configurations with a non-finite result or an error over the tolerance
+
+    AccuracyErrs sphere, flatDem; // smooth sphere (closed formulas) and terrain intersection
+};
+
+// Check the results over the valid domain (fov up to getMaxFov(), view angle up to +/- getmaxViewAng()),
+// including nadir pixel sides (ang_1 == 0), negative view angles and near-horizon rays, and the terrain intersection
+// with a flat DEM (which must match the sphere).
+// A configuration fails when a result is not finite or its error is greater than tol (m).
+AccuracyReport accuracyCheck(double tol);
+
+void printAccuracyReport(FILE *f, const AccuracyReport &report);
+
+// Worst errors of the partial derivatives (CALC_SENS) against central finite differences of the values
+struct SensReport
+{
+    int nConfigs; // number of configurations checked
+
+    int nFailed; // configurations with an error over the tolerance
+
+    double maxLosErr[SENS_NPARAMS], maxPixErr[SENS_NPARAMS]; // max error, relative to the max derivative of the config
+
+    string worstLos[SENS_NPARAMS], worstPix[SENS_NPARAMS]; // configurations of the max errors
+};
+
+// Check the derivatives with respect to all the SensParams, including pixels and pixel sides exactly at nadir.
+// A configuration fails when an error is greater than tol.
+SensReport sensCheck(double tol);
+
+void printSensReport(FILE *f, const SensReport &report);
+
+#endif // AccuracyCheck_H
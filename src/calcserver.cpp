@@ -0,0 +1,296 @@
+#include "calcserver.h"
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QHash>
+#include <QVector>
+#include <QtConcurrent>
+#include <algorithm>
+#include <math.h>
+
+#define BATCH_WINDOW_MS 1 // time to wait for more requests before processing a batch
+#define CACHE_MAX_PX 4000000 // max total number of pixels kept in the result cache
+#define REQ_MAX_PX CACHE_MAX_PX // max number of pixels of a request
+#define LAT_SAMPLES 10000 // number of latencies kept for the statistics
+
+//-----------------------------------------------------------------------------
+// CONSTRUCTORS:
+//-----------------------------------------------------------------------------
+
+CalcServer::CalcServer(QObject *parent) :
+    QObject(parent)
+{
+    server = new QLocalServer(this);
+    connect(server, SIGNAL(newConnection()), this, SLOT(onNewConnection()));
+
+    batchTimer.setSingleShot(true);
+    batchTimer.setInterval(BATCH_WINDOW_MS);
+    connect(&batchTimer, SIGNAL(timeout()), this, SLOT(processBatch()));
+
+    cache.setMaxCost(CACHE_MAX_PX);
+    latPos = 0;
+    nRequests = 0;
+    nCacheHits = 0;
+    nBatches = 0;
+    clock.start();
+}
+
+bool CalcServer::listen(QString name)
+{
+    QLocalServer::removeServer(name); // remove a stale socket left by a crashed server
+
+    return server->listen(name);
+}
+
+QString CalcServer::fullServerName()
+{
+    return server->fullServerName();
+}
+
+QString CalcServer::errorString()
+{
+    return server->errorString();
+}
+
+//-----------------------------------------------------------------------------
+// PRIVATE SLOTS:
+//-----------------------------------------------------------------------------
+
+void CalcServer::onNewConnection()
+{
+    while (server->hasPendingConnections())
+    {
+        QLocalSocket *socket = server->nextPendingConnection();
+        connect(socket, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
+        connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+    }
+}
+
+// Queue the received requests. They are processed when the batch timer expires.
+void CalcServer::onReadyRead()
+{
+    QLocalSocket *socket = qobject_cast<QLocalSocket *>(sender());
+    QJsonParseError err;
+    QJsonDocument doc;
+    QJsonObject resp;
+    PendingReq item;
+
+    while (socket->canReadLine())
+    {
+        QByteArray line = socket->readLine().trimmed();
+        if (line.isEmpty())
+            continue;
+
+        doc = QJsonDocument::fromJson(line, &err);
+        if (err.error != QJsonParseError::NoError || !doc.isObject())
+        {
+            resp["ok"] = false;
+            resp["error"] = "Invalid request";
+            reply(socket, resp, clock.nsecsElapsed());
+            continue;
+        }
+
+        item.socket = socket;
+        item.req = doc.object();
+        item.arrival = clock.nsecsElapsed();
+        pending.append(item);
+    }
+
+    if (!pending.isEmpty() && !batchTimer.isActive())
+        batchTimer.start();
+}
+
+// Process all the queued requests: the distinct configurations that are not in the cache are calculated
+// concurrently, then every request gets its reply and the new results are added to the cache.
+void CalcServer::processBatch()
+{
+    QList<PendingReq> batch;
+    QVector<BatchItem> misses;
+    QHash<QString, CalcResult *> newResults;
+    QString key, reqErr;
+    BatchItem miss;
+
+    batch.swap(pending);
+    nBatches++;
+
+    // Find the distinct configurations that have to be calculated
+    for (int i = 0; i < batch.size(); i++)
+    {
+        if (batch[i].req.contains("cmd") || !validate(batch[i].req).isEmpty())
+            continue;
+
+        key = cacheKey(batch[i].req);
+        if (!cache.contains(key) && !newResults.contains(key))
+        {
+            newResults.insert(key, NULL);
+            miss.req = batch[i].req;
+            miss.res = NULL;
+            misses.append(miss);
+        }
+    }
+
+    QtConcurrent::blockingMap(misses, [](BatchItem &item) { item.res = calc(item.req); });
+
+    for (int i = 0; i < misses.size(); i++)
+        newResults[cacheKey(misses[i].req)] = misses[i].res;
+
+    // Reply
+    for (int i = 0; i < batch.size(); i++)
+    {
+        QJsonObject resp;
+
+        if (batch[i].req.value("cmd").toString() == "stats")
+            resp = stats();
+        else if (batch[i].req.contains("cmd"))
+        {
+            resp["ok"] = false;
+            resp["error"] = "Unknown command";
+        }
+        else if (!(reqErr = validate(batch[i].req)).isEmpty())
+        {
+            resp["ok"] = false;
+            resp["error"] = reqErr;
+        }
+        else
+        {
+            key = cacheKey(batch[i].req);
+            if (newResults.contains(key))
+                resp = resultToJson(newResults[key]);
+            else
+            {
+                resp = resultToJson(cache.object(key));
+                nCacheHits++;
+            }
+        }
+
+        if (batch[i].req.contains("id"))
+            resp["id"] = batch[i].req.value("id");
+
+        if (batch[i].socket)
+            reply(batch[i].socket, resp, batch[i].arrival);
+    }
+
+    // The cache takes the ownership of the new results (it deletes the ones that don't fit)
+    for (QHash<QString, CalcResult *>::iterator it = newResults.begin(); it != newResults.end(); ++it)
+        cache.insert(it.key(), it.value(), (int)it.value()->pixVec.size() + 1);
+}
+
+//-----------------------------------------------------------------------------
+// CUSTOM METHODS:
+//-----------------------------------------------------------------------------
+
+// Check the parameters of a request (empty string: valid). The calculation needs all of them: a missing one must not
+// become 0, and the number of pixels is bounded, so that a request can't take all the memory of the server. The
+// ranges of the geometry are checked by orbitPixCalc() (its error message is the reply).
+QString CalcServer::validate(const QJsonObject &req)
+{
+    const char *names[] = {"h", "fov", "viewAng", "r", "px"};
+    double px;
+
+    for (int k = 0; k < 5; k++)
+        if (!req.value(names[k]).isDouble())
+            return QString("Missing or invalid parameter ") + names[k];
+
+    px = req.value("px").toDouble();
+    if (px != floor(px) || fabs(px) > REQ_MAX_PX)
+        return QString("Number of pixels must be an integer not greater than %1").arg(REQ_MAX_PX);
+
+    return QString();
+}
+
+// Calculate the line of sight and the size of all pixels for the configuration of a (valid) request
+CalcResult *CalcServer::calc(const QJsonObject &req)
+{
+    CalcResult *res = new CalcResult;
+    OrbitPixInput in = orbitPixInput(req["h"].toDouble(), req["fov"].toDouble(), req["viewAng"].toDouble(),
+                                     req["r"].toDouble(), req["px"].toInt());
+    OrbitPixResult calcRes;
+
+    in.maxThreads = 1; // the batch items are already calculated concurrently (orbitPixCalc() is stateless)
+    calcRes = orbitPixCalc(in);
+
+    res->ok = calcRes.err == ERR_NONE;
+    if (res->ok)
+    {
+        res->angVec.swap(calcRes.angVec);
+        res->losVec.swap(calcRes.losVec);
+        res->pixVec.swap(calcRes.pixVec);
+    }
+    else
+        res->errMsg = calcRes.errMsg;
+
+    return res;
+}
+
+QString CalcServer::cacheKey(const QJsonObject &req)
+{
+    return QString("%1 %2 %3 %4 %5")
+            .arg(req["h"].toDouble(), 0, 'g', 17)
+            .arg(req["fov"].toDouble(), 0, 'g', 17)
+            .arg(req["viewAng"].toDouble(), 0, 'g', 17)
+            .arg(req["r"].toDouble(), 0, 'g', 17)
+            .arg(req["px"].toInt());
+}
+
+QJsonObject CalcServer::resultToJson(const CalcResult *res)
+{
+    QJsonObject resp;
+    QJsonArray ang, los, size;
+
+    resp["ok"] = res->ok;
+    if (res->ok)
+    {
+        for (size_t i = 0; i < res->pixVec.size(); i++)
+        {
+            ang.append(res->angVec[i]);
+            los.append(res->losVec[i]);
+            size.append(res->pixVec[i]);
+        }
+        resp["ang"] = ang;
+        resp["los"] = los;
+        resp["size"] = size;
+    }
+    else
+        resp["error"] = QString(res->errMsg.c_str());
+
+    return resp;
+}
+
+// Number of requests, cache hits, batches and the median / 99th percentile latency (ms)
+QJsonObject CalcServer::stats()
+{
+    QJsonObject resp;
+    vector<double> sorted(latencies);
+    double p50 = 0, p99 = 0;
+
+    if (!sorted.empty())
+    {
+        sort(sorted.begin(), sorted.end());
+        p50 = sorted[(sorted.size() - 1) * 50 / 100];
+        p99 = sorted[(sorted.size() - 1) * 99 / 100];
+    }
+
+    resp["requests"] = (double)nRequests;
+    resp["cacheHits"] = (double)nCacheHits;
+    resp["batches"] = (double)nBatches;
+    resp["p50"] = p50;
+    resp["p99"] = p99;
+
+    return resp;
+}
+
+// Send a response and record the latency of the request
+void CalcServer::reply(QLocalSocket *socket, const QJsonObject &resp, qint64 arrival)
+{
+    double latency;
+
+    socket->write(QJsonDocument(resp).toJson(QJsonDocument::Compact));
+    socket->write("\n");
+
+    latency = (clock.nsecsElapsed() - arrival) / 1e6;
+    if ((int)latencies.size() < LAT_SAMPLES)
+        latencies.push_back(latency);
+    else
+        latencies[latPos] = latency;
+    latPos = (latPos + 1) % LAT_SAMPLES;
+    nRequests++;
+}
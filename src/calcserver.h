@@ -0,0 +1,96 @@
+#ifndef CALCSERVER_H
+#define CALCSERVER_H
+
+#include <QObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QPointer>
+#include <QCache>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include "orbitpixcalc.h"
+
+// Result of one calculation (shared between all the clients through the cache)
+struct CalcResult
+{
+    bool ok;
+
+    string errMsg;
+
+    vector<double> angVec, losVec, pixVec;
+};
+
+// Local compute server. The clients connect to a local socket and send one JSON object per line:
+//   {"id": 1, "h": 550, "fov": 0.3142, "viewAng": 0.2618, "r": 6371, "px": 640}   (angles in rad)
+//   {"id": 2, "cmd": "stats"}
+// (h, fov, viewAng, r and px are required, px up to 4000000)
+// and get one JSON object per line back, with the same id:
+//   {"id": 1, "ok": true, "ang": [...], "los": [...], "size": [...]}   (or "ok": false and "error")
+//   {"id": 2, "requests": ..., "cacheHits": ..., "batches": ..., "p50": ..., "p99": ...}   (latencies in ms)
+// Requests arriving from all the clients within BATCH_WINDOW_MS are processed together as one batch.
+class CalcServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CalcServer(QObject *parent = 0);
+
+    bool listen(QString name);
+
+    QString fullServerName();
+
+    QString errorString();
+
+private slots:
+    void onNewConnection();
+
+    void onReadyRead();
+
+    void processBatch();
+
+private:
+    struct PendingReq
+    {
+        QPointer<QLocalSocket> socket;
+        QJsonObject req;
+        qint64 arrival; // ns
+    };
+
+    struct BatchItem
+    {
+        QJsonObject req;
+        CalcResult *res;
+    };
+
+    static QString validate(const QJsonObject &req);
+
+    static CalcResult *calc(const QJsonObject &req);
+
+    static QString cacheKey(const QJsonObject &req);
+
+    QJsonObject resultToJson(const CalcResult *res);
+
+    QJsonObject stats();
+
+    void reply(QLocalSocket *socket, const QJsonObject &resp, qint64 arrival);
+
+    QLocalServer *server;
+
+    QTimer batchTimer;
+
+    QElapsedTimer clock;
+
+    QList<PendingReq> pending;
+
+    QCache<QString, CalcResult> cache;
+
+    vector<double> latencies; // ring buffer with the latencies (ms) of the last requests
+
+    int latPos;
+
+    qint64 nRequests, nCacheHits, nBatches;
+
+};
+
+#endif // CALCSERVER_H
@@ -0,0 +1,387 @@
+#include "demterrain.h"
+#include <math.h>
+#include <string.h>
+#define PI 3.141592653589793
+#define DEM_HEADER_LEN 28
+#define HIT_TOL 1e-7 // precision (km, along the ray) of the terrain intersection
+#define END_MARGIN 1e-9 // (rad) search a bit after the end of the ray, so that rounding errors don't miss a hit there
+
+// In the search of the intersection, a ray at angle ang_1 from nadir is parametrized by the central angle u
+// (planet centre) between the satellite and the points of the ray (u >= 0 along the ray, the central angle
+// of the point is s * u where s is the sign of ang_1). For aa = |ang_1| the distance of the point from the planet
+// centre is rayRadius(u) = (r + h) * sin(aa) / sin(aa + u) (law of sines), which is minimum at u = PI / 2 - aa.
+
+//-----------------------------------------------------------------------------
+// CONSTRUCTORS:
+//-----------------------------------------------------------------------------
+
+DemTerrain::DemTerrain()
+{
+    map = NULL;
+    heights = NULL;
+    nSamples = 0;
+    ang0 = 0;
+    dAng = 0;
+    minHeight = 0;
+}
+
+DemTerrain::~DemTerrain()
+{
+    unload();
+}
+
+//-----------------------------------------------------------------------------
+// LOAD:
+//-----------------------------------------------------------------------------
+
+// Map the DEM file in memory and build the max height pyramid
+bool DemTerrain::load(string fileName)
+{
+    qint64 mapLen;
+
+    unload();
+
+    file.setFileName(QString::fromStdString(fileName));
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        errMsg = "Can't open the DEM file";
+        return false;
+    }
+
+    mapLen = file.size();
+    if (mapLen < DEM_HEADER_LEN)
+    {
+        file.close();
+        errMsg = "Invalid DEM file";
+        return false;
+    }
+
+    map = file.map(0, mapLen); // the file stays open while it is mapped
+    if (map == NULL)
+    {
+        file.close();
+        errMsg = "Can't map the DEM file in memory";
+        return false;
+    }
+
+    memcpy(&nSamples, map + 8, 4);
+    memcpy(&ang0, map + 12, 8);
+    memcpy(&dAng, map + 20, 8);
+    if (memcmp(map, "OPPCDEM1", 8) != 0 || nSamples < 2 || !(dAng > 0)
+            || mapLen < DEM_HEADER_LEN + (qint64)nSamples * (qint64)sizeof(float))
+    {
+        unload();
+        errMsg = "Invalid DEM file";
+        return false;
+    }
+
+    heights = (const float *)(map + DEM_HEADER_LEN);
+    buildPyramid();
+
+    return true;
+}
+
+// Use a profile kept in memory (a copy of heights, same units as the file) instead of a file
+bool DemTerrain::loadProfile(const vector<float> &heights, double ang0, double dAng)
+{
+    unload();
+
+    if (heights.size() < 2 || !(dAng > 0))
+    {
+        errMsg = "Invalid DEM profile";
+        return false;
+    }
+
+    profile = heights;
+    nSamples = profile.size();
+    this->ang0 = ang0;
+    this->dAng = dAng;
+    this->heights = profile.data();
+    buildPyramid();
+
+    return true;
+}
+
+void DemTerrain::unload()
+{
+    if (map)
+        file.unmap(map);
+    if (file.isOpen())
+        file.close();
+
+    map = NULL;
+    profile.clear();
+    heights = NULL;
+    nSamples = 0;
+    maxPyramid.clear();
+}
+
+// Level 0: one cell between each pair of consecutive samples. Level L: one cell for each pair of cells of level L-1.
+void DemTerrain::buildPyramid()
+{
+    vector<float> level(nSamples - 1);
+    int n;
+
+    minHeight = 0;
+    for (int j = 0; j < nSamples; j++)
+        if (heights[j] < minHeight)
+            minHeight = heights[j];
+
+    for (int j = 0; j < nSamples - 1; j++)
+        level[j] = heights[j] > heights[j+1] ? heights[j] : heights[j+1];
+    maxPyramid.push_back(level);
+
+    while (maxPyramid.back().size() > 1)
+    {
+        const vector<float> &prev = maxPyramid.back();
+        n = (prev.size() + 1) / 2;
+        level.assign(n, 0);
+        for (int j = 0; j < n; j++)
+            level[j] = 2 * j + 1 < (int)prev.size() && prev[2*j+1] > prev[2*j] ? prev[2*j+1] : prev[2*j];
+        maxPyramid.push_back(level);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// CALC METHODS:
+//-----------------------------------------------------------------------------
+
+// Terrain height (km) at the central angle ang (linear interpolation between the samples)
+double DemTerrain::height(double ang) const
+{
+    double t, frac;
+    int j;
+
+    if (!heights)
+        return 0;
+
+    t = (ang - ang0) / dAng;
+    if (t < 0 || t > nSamples - 1)
+        return 0;
+
+    j = (int)t;
+    if (j > nSamples - 2)
+        j = nSamples - 2;
+    frac = t - j;
+
+    return (1 - frac) * heights[j] + frac * heights[j+1];
+}
+
+double DemTerrain::rayRadius(double u, double aa, double r, double h) const
+{
+    return (r + h) * sin(aa) / sin(aa + u);
+}
+
+// Distance along the ray from the satellite (law of sines)
+double DemTerrain::rayLos(double u, double aa, double r, double h) const
+{
+    return (r + h) * sin(u) / sin(aa + u);
+}
+
+// Height of the ray above the terrain
+double DemTerrain::rayHitFunc(double u, double aa, int s, double r, double h) const
+{
+    return rayRadius(u, aa, r, h) - r - height(s * u);
+}
+
+// Search the first intersection of the ray with the terrain between the samples of a level 0 cell ([u0, u1]).
+// The ray radius is convex in u and the terrain is linear, so the height of the ray above the terrain (f) is convex too.
+bool DemTerrain::leafHit(double u0, double u1, double aa, int s, double r, double h, double *uHit) const
+{
+    double ua, ub, um, f0, f1, d0, d1, slope, uT, uc, ud, fc, fd;
+    const double g = 0.3819660112501051; // golden section
+
+    f0 = rayHitFunc(u0, aa, s, r, h);
+    if (f0 <= 0)
+    {
+        *uHit = u0;
+        return true;
+    }
+
+    ua = u0;
+    ub = u1;
+    f1 = rayHitFunc(u1, aa, s, r, h);
+    if (f1 > 0)
+    {
+        // both ends above the terrain. Cheap test first: f is above its tangents at u0 and u1.
+        if (rayLos(u1, aa, r, h) - rayLos(u0, aa, r, h) <= HIT_TOL)
+            return false;
+        slope = (height(s * u1) - height(s * u0)) / (u1 - u0);
+        d0 = -rayRadius(u0, aa, r, h) / tan(aa + u0) - slope;
+        d1 = -rayRadius(u1, aa, r, h) / tan(aa + u1) - slope;
+        if (d0 >= 0 || d1 <= 0)
+            return false; // f is monotonic in the cell
+        uT = (f1 - f0 + d0 * u0 - d1 * u1) / (d0 - d1);
+        if (f0 + d0 * (uT - u0) > 0)
+            return false;
+
+        // find the lowest point of the ray above the terrain (golden section search)
+        uc = u0 + g * (u1 - u0);
+        ud = u1 - g * (u1 - u0);
+        fc = rayHitFunc(uc, aa, s, r, h);
+        fd = rayHitFunc(ud, aa, s, r, h);
+        while (rayLos(ud, aa, r, h) - rayLos(uc, aa, r, h) > HIT_TOL && fc > 0 && fd > 0)
+        {
+            if (fc < fd)
+            {
+                u1 = ud;
+                ud = uc;
+                fd = fc;
+                uc = u0 + g * (u1 - u0);
+                fc = rayHitFunc(uc, aa, s, r, h);
+            }
+            else
+            {
+                u0 = uc;
+                uc = ud;
+                fc = fd;
+                ud = u1 - g * (u1 - u0);
+                fd = rayHitFunc(ud, aa, s, r, h);
+            }
+        }
+
+        if (fc <= 0)
+            ub = uc;
+        else if (fd <= 0)
+            ub = ud;
+        else
+            return false; // the ray passes over the cell
+    }
+
+    // bisection of [ua, ub] (above the terrain at ua, below at ub). The tolerance is along the ray: near nadir
+    // the ray is almost perpendicular to the terrain, so a small central angle is a long piece of the ray.
+    while (rayLos(ub, aa, r, h) - rayLos(ua, aa, r, h) > HIT_TOL)
+    {
+        um = (ua + ub) / 2;
+        if (rayHitFunc(um, aa, s, r, h) > 0)
+            ua = um;
+        else
+            ub = um;
+    }
+
+    *uHit = ub;
+
+    return true;
+}
+
+// Search the first intersection of the ray with the terrain under the cell j of the pyramid level. The cell is skipped
+// when the lowest point of the ray above it is higher than the highest sample under it.
+bool DemTerrain::cellHit(int level, int j, double aa, int s, double uEnd, double r, double h, double *uHit) const
+{
+    int first, last, width = 1 << level;
+    double u0, u1, uMin;
+
+    first = j * width;
+    last = (j + 1) * width < nSamples - 1 ? (j + 1) * width : nSamples - 1;
+    if (s > 0)
+    {
+        u0 = ang0 + first * dAng;
+        u1 = ang0 + last * dAng;
+    }
+    else
+    {
+        u0 = -(ang0 + last * dAng);
+        u1 = -(ang0 + first * dAng);
+    }
+
+    if (u0 < 0)
+        u0 = 0;
+    if (u1 > uEnd)
+        u1 = uEnd;
+    if (u0 >= u1)
+        return false;
+
+    uMin = PI / 2 - aa;
+    uMin = uMin < u0 ? u0 : (uMin > u1 ? u1 : uMin);
+    if (rayRadius(uMin, aa, r, h) > r + maxPyramid[level][j])
+        return false;
+
+    if (level == 0)
+        return leafHit(u0, u1, aa, s, r, h, uHit);
+
+    // visit the children in the order they are crossed by the ray
+    for (int k = 0; k < 2; k++)
+    {
+        int child = s > 0 ? 2 * j + k : 2 * j + 1 - k;
+        if (child < (int)maxPyramid[level-1].size() && cellHit(level - 1, child, aa, s, uEnd, r, h, uHit))
+            return true;
+    }
+
+    return false;
+}
+
+// Intersect the ray at angle ang_1 (from nadir) with the terrain. Returns the line of sight and the coordinates
+// of the intersection (x: along the surface, y: towards the satellite, origin at the planet centre).
+// Returns false if the ray misses the planet.
+bool DemTerrain::rayHit(double ang_1, double r, double h, double *los, double *x, double *y) const
+{
+    double aa = fabs(ang_1), c, rr, uEnd, u, uCov0, uCov1, rho;
+    int s = ang_1 >= 0 ? 1 : -1;
+    int top;
+    bool hit = false;
+
+    if (aa == 0) // nadir
+    {
+        *los = h - height(0);
+        *x = 0;
+        *y = r + height(0);
+        return true;
+    }
+
+    c = (r + h) * sin(aa);
+
+    if (heights)
+    {
+        // the ray can't hit the terrain after the (near) intersection with the sphere of the lowest terrain
+        // or, if it misses it, after the (far) intersection with the sphere of the highest terrain
+        top = maxPyramid.size() - 1;
+        rr = r + minHeight;
+        if (c <= rr)
+            uEnd = asin(c / rr) - aa;
+        else if (c <= r + maxPyramid[top][0])
+            uEnd = PI - asin(c / (r + maxPyramid[top][0])) - aa;
+        else
+            uEnd = -1; // above all the terrain
+        uEnd += END_MARGIN;
+
+        for (int k = 0; k < (int)maxPyramid[top].size() && !hit; k++)
+            hit = cellHit(top, k, aa, s, uEnd, r, h, &u);
+    }
+
+    if (!hit)
+    {
+        // outside of the profile, the terrain is the sphere
+        if (c > r)
+            return false;
+        u = asin(c / r) - aa;
+
+        if (heights)
+        {
+            uCov0 = s > 0 ? ang0 : -(ang0 + (nSamples - 1) * dAng);
+            uCov1 = s > 0 ? ang0 + (nSamples - 1) * dAng : -ang0;
+            if (u > uCov0 && u < uCov1) // the ray got under the sphere over the profile: it hits where the profile ends
+                u = uCov1;
+        }
+    }
+
+    rho = rayRadius(u, aa, r, h);
+    *los = rayLos(u, aa, r, h);
+    *x = rho * sin(s * u);
+    *y = rho * cos(s * u);
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// GETTERS:
+//-----------------------------------------------------------------------------
+
+bool DemTerrain::isLoaded() const
+{
+    return heights != NULL;
+}
+
+string DemTerrain::getErrMsg()
+{
+    return errMsg;
+}
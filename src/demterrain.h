@@ -0,0 +1,80 @@
+#ifndef DemTerrain_H
+#define DemTerrain_H
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <QFile>
+
+using namespace std;
+
+// Elevation profile of the terrain along the scan plane, read from a memory-mapped file.
+//
+// File format (little-endian, a flat profile: a 28-byte header and the contiguous heights):
+//   char   magic[8]   "OPPCDEM1"
+//   int32  nSamples   number of height samples (>= 2)
+//   double ang0       central angle of the first sample (rad, positive on the side of the positive view angles)
+//   double dAng       central angle between two samples (rad, > 0)
+//   float  heights[nSamples]   terrain height above the sphere of radius r (km)
+// Outside the profile the terrain is the smooth sphere (height 0).
+// rayHit() and the other const methods only read the terrain, so they can be called from many threads at a time.
+class DemTerrain
+{
+
+public:
+
+    DemTerrain();
+
+    ~DemTerrain();
+
+    DemTerrain(const DemTerrain &) = delete; // a copy would unmap the file twice
+
+    DemTerrain &operator=(const DemTerrain &) = delete;
+
+    bool load(string fileName);
+
+    bool loadProfile(const vector<float> &heights, double ang0, double dAng);
+
+    void unload();
+
+    bool isLoaded() const;
+
+    string getErrMsg();
+
+    double height(double ang) const;
+
+    bool rayHit(double ang_1, double r, double h, double *los, double *x, double *y) const;
+
+private:
+
+    double rayRadius(double u, double aa, double r, double h) const;
+
+    double rayLos(double u, double aa, double r, double h) const;
+
+    double rayHitFunc(double u, double aa, int s, double r, double h) const;
+
+    bool cellHit(int level, int j, double aa, int s, double uEnd, double r, double h, double *uHit) const;
+
+    bool leafHit(double u0, double u1, double aa, int s, double r, double h, double *uHit) const;
+
+    void buildPyramid();
+
+    string errMsg;
+
+    QFile file;
+
+    uchar *map;
+
+    vector<float> profile; // heights given by loadProfile() (instead of a file)
+
+    const float *heights;
+
+    int nSamples;
+
+    double ang0, dAng, minHeight;
+
+    vector< vector<float> > maxPyramid; // maxPyramid[L][j]: max height of the samples under the cell j of level L
+
+};
+
+#endif // DemTerrain_H
@@ -0,0 +1,125 @@
+#ifndef DualNum_H
+#define DualNum_H
+
+#include <math.h>
+
+// Dual number for forward-mode automatic differentiation: a value and its partial derivatives
+// with respect to N independent variables. All the derivatives are propagated in a single pass.
+template <typename T, int N>
+class DualNum
+{
+
+public:
+
+    DualNum(T val = 0)
+    {
+        this->val = val;
+        for (int k = 0; k < N; k++)
+            der[k] = 0;
+    }
+
+    // Independent variable number k (its derivative with respect to itself is 1)
+    static DualNum var(T val, int k)
+    {
+        DualNum x(val);
+        x.der[k] = 1;
+        return x;
+    }
+
+    T val;
+
+    T der[N];
+
+    // Arithmetic operators
+
+    friend DualNum operator-(const DualNum &a)
+    {
+        DualNum c(-a.val);
+        for (int k = 0; k < N; k++)
+            c.der[k] = -a.der[k];
+        return c;
+    }
+
+    friend DualNum operator+(const DualNum &a, const DualNum &b)
+    {
+        DualNum c(a.val + b.val);
+        for (int k = 0; k < N; k++)
+            c.der[k] = a.der[k] + b.der[k];
+        return c;
+    }
+
+    friend DualNum operator-(const DualNum &a, const DualNum &b)
+    {
+        DualNum c(a.val - b.val);
+        for (int k = 0; k < N; k++)
+            c.der[k] = a.der[k] - b.der[k];
+        return c;
+    }
+
+    friend DualNum operator*(const DualNum &a, const DualNum &b)
+    {
+        DualNum c(a.val * b.val);
+        for (int k = 0; k < N; k++)
+            c.der[k] = a.der[k] * b.val + a.val * b.der[k];
+        return c;
+    }
+
+    friend DualNum operator/(const DualNum &a, const DualNum &b)
+    {
+        DualNum c(a.val / b.val);
+        for (int k = 0; k < N; k++)
+            c.der[k] = (a.der[k] - c.val * b.der[k]) / b.val;
+        return c;
+    }
+
+    friend DualNum operator+(const DualNum &a, T b) { return a + DualNum(b); }
+
+    friend DualNum operator+(T a, const DualNum &b) { return DualNum(a) + b; }
+
+    friend DualNum operator-(const DualNum &a, T b) { return a - DualNum(b); }
+
+    friend DualNum operator-(T a, const DualNum &b) { return DualNum(a) - b; }
+
+    friend DualNum operator*(const DualNum &a, T b)
+    {
+        DualNum c(a.val * b);
+        for (int k = 0; k < N; k++)
+            c.der[k] = a.der[k] * b;
+        return c;
+    }
+
+    friend DualNum operator*(T a, const DualNum &b) { return b * a; }
+
+    friend DualNum operator/(const DualNum &a, T b) { return a * (1 / b); }
+
+    friend DualNum operator/(T a, const DualNum &b) { return DualNum(a) / b; }
+
+    // Elementary functions (chain rule: f(a)' = f'(a.val) * a')
+
+    friend DualNum sin(const DualNum &a) { return chain(a, sin(a.val), cos(a.val)); }
+
+    friend DualNum cos(const DualNum &a) { return chain(a, cos(a.val), -sin(a.val)); }
+
+    friend DualNum asin(const DualNum &a) { return chain(a, asin(a.val), 1 / sqrt(1 - a.val * a.val)); }
+
+    friend DualNum sqrt(const DualNum &a)
+    {
+        T s = sqrt(a.val);
+        return chain(a, s, 1 / (2 * s));
+    }
+
+    friend DualNum pow(const DualNum &a, int n) { return chain(a, pow(a.val, n), n * pow(a.val, n - 1)); }
+
+private:
+
+    static DualNum chain(const DualNum &a, T f, T df)
+    {
+        DualNum c(f);
+        for (int k = 0; k < N; k++)
+            c.der[k] = df * a.der[k];
+        return c;
+    }
+
+};
+
+#endif // DualNum_H
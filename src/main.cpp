@@ -1,8 +1,55 @@
 #include "mainwindow.h"
+#include "calcserver.h"
+#include "sweepspec.h"
 #include <QApplication>
 
 int main(int argc, char *argv[])
 {
+    // Parametric sweep (no GUI): OrbitPixelParamsCalc --sweep <spec file> [output file, default stdout]
+    if (argc > 1 && QString(argv[1]) == "--sweep")
+    {
+        SweepSpec spec;
+        FILE *f;
+        bool ok;
+
+        if (argc < 3 || !spec.load(argv[2]))
+        {
+            fprintf(stderr, "%s\n", argc < 3 ? "Missing sweep spec file" : spec.getErrMsg().c_str());
+            return 1;
+        }
+
+        f = argc > 3 ? fopen(argv[3], "w") : stdout;
+        if (f == NULL)
+        {
+            fprintf(stderr, "Can't create the output file\n");
+            return 1;
+        }
+
+        ok = spec.run(f);
+        if (f != stdout)
+            fclose(f);
+
+        return ok ? 0 : 1;
+    }
+
+    // Server mode (no GUI): OrbitPixelParamsCalc --server [name]
+    if (argc > 1 && QString(argv[1]) == "--server")
+    {
+        QCoreApplication a(argc, argv);
+        CalcServer server;
+        QString name = argc > 2 ? QString(argv[2]) : QString("OrbitPixelParamsCalc");
+
+        if (!server.listen(name))
+        {
+            fprintf(stderr, "Can't start the server: %s\n", server.errorString().toStdString().c_str());
+            return 1;
+        }
+        printf("Listening on %s\n", server.fullServerName().toStdString().c_str());
+        fflush(stdout);
+
+        return a.exec();
+    }
+
     QApplication a(argc, argv);
     MainWindow w;
     w.show();
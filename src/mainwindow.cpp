@@ -2,6 +2,8 @@
 #include "ui_mainwindow.h"
 
 #define PI 3.141592653589793
+#define RAY_SPACING 3 // min distance (in view pixels) between two drawn rays
+#define BAR_SPACING 2 // min length (in view pixels) of a GSD colour bar segment
 
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
@@ -9,6 +11,13 @@ MainWindow::MainWindow(QWidget *parent) :
 {
     ui->setupUi(this);
 
+    // Preview scene (static items are created once and only their geometry is updated):
+    scene = new QGraphicsScene(this);
+    initScene();
+    ui->graphicsView->setScene(scene);
+    ui->graphicsView->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    ui->graphicsView->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+
     // Window title:
     MainWindow::setWindowTitle("Orbit pixel parameters calculator");
 
@@ -139,16 +148,18 @@ void MainWindow::on_calcPushButton_clicked()
         orbitPixParamsObj->setR(r);
         orbitPixParamsObj->setPx(px);
     }
+    orbitPixParamsObj->setDem(dem.isLoaded() ? &dem : NULL);
 
     orbitPixParamsObj->losCalc(); // calculate the line of sight for all cases (pixels)
     orbitPixParamsObj->pixSizeCalc(); // calculate the corresponding size (on Earth) of all pixels
 
-    if (!orbitPixParamsObj->getErrFov() && !orbitPixParamsObj->getErrViewAng())
+    if (!orbitPixParamsObj->getErr())
     {
         // Get the results (vectors) from OrbitPixParams class
         angVec = orbitPixParamsObj->getAngVec();
         losVec = orbitPixParamsObj->getLosVec();
         pixVec = orbitPixParamsObj->getPixVec();
+        dAngSidesVec = orbitPixParamsObj->getDAngSizeVec();
 
         // Prepare the table
         ui->tableWidget->setRowCount(px);
@@ -252,6 +263,52 @@ void MainWindow::on_exportPushButton_clicked()
     }
 }
 
+// Toggle the per-pixel rays and the GSD colour bar
+void MainWindow::on_raysCheckBox_toggled(bool checked)
+{
+    Q_UNUSED(checked); // the state is read in drawFig()
+
+    if (ui->tableWidget->rowCount() > 0) // redraw only if there are results to show
+        drawFig();
+    else
+        clearScene(scene);
+}
+
+// Load a DEM file (cancel the dialog to go back to the smooth sphere)
+void MainWindow::on_demPushButton_clicked()
+{
+    QString demFile = QFileDialog::getOpenFileName(this, "Select DEM file", dir, "DEM files (*.dem);;All files (*)");
+
+    if (demFile.isEmpty())
+        return; // cancelled: keep the current terrain
+
+    clearScene(scene);
+    ui->tableWidget->setRowCount(0);
+
+    if (dem.load(demFile.toStdString()))
+    {
+        ui->demPushButton->setText("DEM: " + QFileInfo(demFile).fileName());
+        ui->clearDemPushButton->setEnabled(true);
+    }
+    else
+    {
+        ui->demPushButton->setText("Load DEM...");
+        ui->clearDemPushButton->setEnabled(false);
+        msgBox.setText(QString(dem.getErrMsg().c_str()));
+        msgBox.exec();
+    }
+}
+
+void MainWindow::on_clearDemPushButton_clicked()
+{
+    clearScene(scene);
+    ui->tableWidget->setRowCount(0);
+
+    dem.unload();
+    ui->demPushButton->setText("Load DEM...");
+    ui->clearDemPushButton->setEnabled(false);
+}
+
 //-----------------------------------------------------------------------------
 // CUSTOM METHODS:
 //-----------------------------------------------------------------------------
@@ -303,28 +360,180 @@ double MainWindow::convToGrad(double angle)
     return val;
 }
 
-// Clear preview window
+// Create the static items of the preview scene (hidden until the first calculation)
+void MainWindow::initScene()
+{
+    QPixmap image(":/sat.png");
+    QPen linePen;
+    QPen planetSurface;
+    QPen rayPen;
+    QBrush planetBrush;
+    QColor planetFillColor;
+
+    // Drawing parameters
+    linePen.setWidth(2);
+    linePen.setColor(Qt::gray);
+    linePen.setStyle(Qt::DotLine);
+    rayPen.setColor(QColor(128, 128, 128, 90));
+    rayPen.setCosmetic(true);
+    planetSurface.setWidth(2);
+    planetBrush.setStyle(Qt::Dense4Pattern);
+    planetFillColor.setRgb(102,77,0);
+    planetBrush.setColor(planetFillColor);
+
+    // Fov angle sides and pixel rays
+    line_1 = scene->addLine(QLineF(), linePen);
+    line_2 = scene->addLine(QLineF(), linePen);
+    raysItem = scene->addPath(QPainterPath(), rayPen);
+
+    // Satellite image
+    satItem = scene->addPixmap(image);
+    satItem->setOffset(-25, -25);
+
+    // Planet
+    planetItem = scene->addEllipse(QRectF(), planetSurface, planetBrush);
+
+    clearScene(scene);
+}
+
+// Clear preview window (hide the items, they are reused by the next drawing)
 void MainWindow::clearScene(QGraphicsScene *scene)
 {
-    if (scene)
-        scene->clear();
+    if (!scene)
+        return;
+
+    line_1->setVisible(false);
+    line_2->setVisible(false);
+    raysItem->setVisible(false);
+    satItem->setVisible(false);
+    planetItem->setVisible(false);
+    for (size_t i = 0; i < gsdBarItems.size(); i++)
+        gsdBarItems[i]->setVisible(false);
+}
+
+// Scene coordinates of the ground end of the i-th fov segmentation side (0 <= i <= px)
+QPointF MainWindow::edgePoint(int i, double factor)
+{
+    double ang = viewAng + fov / 2 - i * (fov / px);
+
+    return QPointF((-dAngSidesVec[i] * sin(ang) + r) * factor, (dAngSidesVec[i] * cos(ang) - h) * factor);
+}
+
+// Length (in view pixels) of the footprint between its first and last finite sides. With a DEM, the sides of a ray
+// that misses the planet (rounding at the horizon) are nan, and they are not drawn.
+double MainWindow::footprintLen(double factor)
+{
+    int i0 = 0, i1 = px;
+
+    while (i0 < px && !isfinite(dAngSidesVec[i0]))
+        i0++;
+    while (i1 > i0 && !isfinite(dAngSidesVec[i1]))
+        i1--;
+
+    return isfinite(dAngSidesVec[i0]) ? QLineF(edgePoint(i0, factor), edgePoint(i1, factor)).length() : 0;
+}
+
+// Draw the rays of the pixel edges as a single path, keeping at most one ray every RAY_SPACING view pixels
+void MainWindow::drawRays(double factor)
+{
+    QPainterPath path;
+    QPointF sat(r * factor, -h * factor);
+    int maxRays, step;
+
+    maxRays = (int)(footprintLen(factor) / RAY_SPACING) + 1;
+    step = px / maxRays + 1;
+
+    for (int i = 0; i < px; i += step)
+    {
+        if (!isfinite(dAngSidesVec[i]))
+            continue;
+        path.moveTo(sat);
+        path.lineTo(edgePoint(i, factor));
+    }
+    if (isfinite(dAngSidesVec[px]))
+    {
+        path.moveTo(sat);
+        path.lineTo(edgePoint(px, factor));
+    }
+
+    raysItem->setPath(path);
+    raysItem->setVisible(true);
+}
+
+// Draw the pixel size (GSD) along the footprint as a colour bar (blue: min size, red: max size).
+// Consecutive pixels are merged so that each segment is at least BAR_SPACING view pixels long.
+void MainWindow::drawGsdBar(double factor)
+{
+    QPen barPen;
+    QColor color;
+    double minSize, maxSize, sum, norm;
+    int maxSeg, step, nSeg, i1, n;
+
+    // The sizes of the pixels that miss the planet (DEM) are nan: they are left out of the range and the segments
+    minSize = INFINITY;
+    maxSize = -INFINITY;
+    for (int i = 0; i < px; i++)
+    {
+        if (pixVec[i] < minSize)
+            minSize = pixVec[i];
+        if (pixVec[i] > maxSize)
+            maxSize = pixVec[i];
+    }
+
+    maxSeg = (int)(footprintLen(factor) / BAR_SPACING) + 1;
+    step = px / maxSeg + 1;
+    nSeg = (px + step - 1) / step;
+
+    // Grow the pool of segments if needed
+    barPen.setWidth(4);
+    barPen.setCosmetic(true);
+    barPen.setCapStyle(Qt::FlatCap);
+    while ((int)gsdBarItems.size() < nSeg)
+    {
+        QGraphicsLineItem *seg = scene->addLine(QLineF(), barPen);
+        seg->setZValue(1); // above the planet
+        gsdBarItems.push_back(seg);
+    }
+
+    for (int k = 0; k < nSeg; k++)
+    {
+        i1 = (k + 1) * step < px ? (k + 1) * step : px;
+
+        sum = 0;
+        n = 0;
+        for (int i = k * step; i < i1; i++)
+            if (isfinite(pixVec[i]))
+            {
+                sum += pixVec[i];
+                n++;
+            }
+        if (n == 0 || !isfinite(dAngSidesVec[k * step]) || !isfinite(dAngSidesVec[i1]))
+        {
+            gsdBarItems[k]->setVisible(false);
+            continue;
+        }
+        norm = maxSize > minSize ? (sum / n - minSize) / (maxSize - minSize) : 0;
+        color.setHsvF((1 - norm) * 2.0 / 3.0, 1, 1);
+
+        barPen.setColor(color);
+        gsdBarItems[k]->setPen(barPen);
+        gsdBarItems[k]->setLine(QLineF(edgePoint(k * step, factor), edgePoint(i1, factor)));
+        gsdBarItems[k]->setVisible(true);
+    }
+
+    for (size_t k = nSeg; k < gsdBarItems.size(); k++)
+        gsdBarItems[k]->setVisible(false);
 }
 
 void MainWindow::drawFig()
 {
     double side1Y, side1X, side2Y, side2X, side1, side2, dx, dy, factor, margin, winH, winW;
-    QPixmap image;
-    QGraphicsLineItem *line_1, *line_2;
-    QGraphicsEllipseItem *planet;
-    QPen linePen;
-    QPen planetSurface;
-    QBrush planetBrush;
-    QColor planetFillColor;
-    QGraphicsPixmapItem *pixmapItem;
+
+    clearScene(scene);
 
     // Get the length of the fov angle sides
-    side1 = orbitPixParamsObj->getDAngSizeVec()[0];
-    side2 = orbitPixParamsObj->getDAngSizeVec()[px];
+    side1 = dAngSidesVec[0];
+    side2 = dAngSidesVec[px];
 
     // Calculate the coordinates of the end of the fov angle sides
     side1X = side1 * sin(viewAng + fov / 2);
@@ -338,16 +547,6 @@ void MainWindow::drawFig()
     else
         dx = fabs(side2X - side1X) > fabs(side2X) ? fabs(side2X - side1X) : fabs(side2X);
 
-    // Drawing parameters
-    image.load("../icons/sat.png");
-    linePen.setWidth(2);
-    linePen.setColor(Qt::gray);
-    linePen.setStyle(Qt::DotLine);
-    planetSurface.setWidth(2);
-    planetBrush.setStyle(Qt::Dense4Pattern);
-    planetFillColor.setRgb(102,77,0);
-    planetBrush.setColor(planetFillColor);
-
     // Calculate the factor and the margin
     winH = ui->graphicsView->height();
     winW = ui->graphicsView->width();
@@ -361,24 +560,27 @@ void MainWindow::drawFig()
     else
         margin = 50;
 
-    scene = new QGraphicsScene;
+    // Update the lines
+    line_1->setLine(r * factor, -h * factor, (-side1X + r) * factor, (side1Y - h) * factor);
+    line_2->setLine(r * factor, -h * factor, (-side2X + r) * factor, (side2Y - h) * factor);
+    line_1->setVisible(true);
+    line_2->setVisible(true);
 
-    // Draw the lines
-    line_1 = scene->addLine(r * factor, -h * factor, (-side1X + r) * factor, (side1Y - h) * factor);
-    line_2 = scene->addLine(r * factor, -h * factor, (-side2X + r) * factor, (side2Y - h) * factor);
-    line_1->setPen(linePen);
-    line_2->setPen(linePen);
+    // Update the satellite image
+    satItem->setPos(factor * r, -h * factor);
+    satItem->setRotation((180 / PI) * viewAng);
+    satItem->setVisible(true);
 
-    // Draw  the satellite image
-    pixmapItem = scene->addPixmap(image);
-    pixmapItem->setOffset(-25, -25);
-    pixmapItem->setPos(factor * r, -h * factor);
-    pixmapItem->setRotation((180 / PI) * viewAng);
+    // Update the planet
+    planetItem->setRect(0, 0, 2 * r * factor, 2 * r * factor);
+    planetItem->setVisible(true);
 
-    // Draw the planet
-    planet = scene->addEllipse(0, 0, 2 * r * factor, 2 * r * factor);
-    planet->setBrush(planetBrush);
-    planet->setPen(planetSurface);
+    // Per-pixel rays and GSD colour bar
+    if (ui->raysCheckBox->isChecked())
+    {
+        drawRays(factor);
+        drawGsdBar(factor);
+    }
 
     // Set the scene rectangle
     if (viewAng >= fov / 2)
@@ -387,11 +589,4 @@ void MainWindow::drawFig()
         scene->setSceneRect(r * factor - margin, -h * factor - 50, winW, (h + dy) * factor + 100);
     else
         scene->setSceneRect((r - side1X) * factor - margin, -h * factor - 50, winW, (h + dy) * factor + 100);
-
-    // Set the scene
-    ui->graphicsView->setScene(scene);
-
-    // Remove scroll bars
-    ui->graphicsView->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-    ui->graphicsView->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
 }
@@ -6,6 +6,7 @@
 #include <QMessageBox>
 #include <QFileDialog>
 #include <QGraphicsPixmapItem>
+#include <QGraphicsPathItem>
 #include "orbitpixparams.h"
 
 namespace Ui {
@@ -55,12 +56,27 @@ private slots:
 
     void on_exportPushButton_clicked();
 
+    void on_raysCheckBox_toggled(bool checked);
+
+    void on_demPushButton_clicked();
+
+    void on_clearDemPushButton_clicked();
 
 private:   
+    void initScene();
+
     void clearScene(QGraphicsScene *scene);
 
     void drawFig();
 
+    void drawRays(double factor);
+
+    void drawGsdBar(double factor);
+
+    QPointF edgePoint(int i, double factor);
+
+    double footprintLen(double factor);
+
     Ui::MainWindow *ui;
 
     int px;
@@ -73,10 +89,22 @@ private:
 
     OrbitPixParams *orbitPixParamsObj;
 
+    DemTerrain dem;
+
     vector<double> angVec, dAngSidesVec, pixVec, losVec;
 
     QGraphicsScene *scene;
 
+    QGraphicsLineItem *line_1, *line_2; // fov angle sides
+
+    QGraphicsPathItem *raysItem; // per-pixel ray fan (decimated)
+
+    QGraphicsPixmapItem *satItem;
+
+    QGraphicsEllipseItem *planetItem;
+
+    vector<QGraphicsLineItem *> gsdBarItems; // reusable pool of colour bar segments
+
 };
 
 #endif // MAINWINDOW_H
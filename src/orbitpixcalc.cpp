@@ -0,0 +1,517 @@
+#include "orbitpixcalc.h"
+#include "dualnum.h"
+#include <math.h>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <algorithm>
+#define PI 3.141592653589793
+#define PAR_MIN_PX 65536 // below this number of pixels the calculations stay single-threaded
+#define PAR_MIN_PX_DEM 4096 // same for the (much slower) terrain intersections
+#define PAR_CHUNK 4096 // pixels per chunk (the working set of a chunk fits in the L1/L2 cache)
+
+typedef DualNum<double, SENS_NPARAMS> SensDual;
+
+//-----------------------------------------------------------------------------
+// GEOMETRY KERNELS:
+//-----------------------------------------------------------------------------
+
+// Law of sines, case 1: two sides and one non-enclosed angle are known, calculate the oposite angle of side_2.
+template <typename T>
+static T sinLawAng(T side_1, T side_2, T angle_1)
+{
+    T angle_2;
+
+    angle_2 = asin((side_2) * sin(angle_1) / side_1);
+
+    return angle_2;
+}
+
+// Law of sines, case 2: two angles and a side are known, calculate the oposite side of angle_2.
+template <typename T>
+static T sinLawSide(T angle_1, T angle_2, T side_1)
+{
+    T side_2;
+
+    side_2 = side_1 * sin(angle_2) / sin(angle_1);
+
+    return side_2;
+}
+
+// Law of cosines: two sides and the enclosed angle are known, calculate the third side.
+template <typename T>
+static T cosLaw(T side_1, T side_2, T angle)
+{
+    T side_3;
+
+    // side_1^2 + side_2^2 - 2 * side_1 * side_2 * cos(angle), rearranged to avoid the cancellation when side_3 is
+    // much smaller than side_1 and side_2 (small pixels)
+    side_3 = sqrt(pow(side_1 - side_2, 2) + 4 * side_1 * side_2 * pow(sin(angle / 2), 2));
+
+    return side_3;
+}
+
+// Calculate the length of a straight line, starting from the satellite and ending on the planet's surface (/| when this angle is given).
+template <typename T>
+static T strtLineLenCalc(T ang_1, T r, T h)
+{
+    T ang_2, ang_3, lineLen;
+
+    ang_2 = sinLawAng(r, r + h, ang_1); // supplementary of the (obtuse) angle on the planet's surface
+    ang_3 = ang_2 - ang_1; // = PI - ang_1 - (PI - ang_2), without losing precision for small angles
+    lineLen = sinLawSide(ang_1, ang_3, r);
+
+    return lineLen;
+}
+
+// Same line of sight as strtLineLenCalc(), as the nearest root of the ray-sphere intersection. There is no division
+// by sin(ang_1), so its derivatives stay accurate at (and near) nadir.
+template <typename T>
+static T rootLineLenCalc(T ang_1, T r, T h)
+{
+    T s, lineLen;
+
+    s = (r + h) * sin(ang_1);
+    lineLen = h * (2.0 * r + h) / ((r + h) * cos(ang_1) + sqrt(r * r - s * s));
+
+    return lineLen;
+}
+
+// Calculate the length of the i-th side (0 <= i <= px) of the angles resulting after the segmetation of the fov into px parts.
+static double dAngSideCalc(const OrbitPixInput &in, double dViewAng, int i)
+{
+    double ang_1, side;
+
+    ang_1 = in.viewAng + in.fov / 2 - i * dViewAng;
+    if (ang_1)
+        side = strtLineLenCalc(ang_1, in.r, in.h);
+    else // do not use the law of sines when the angle_1 is equal to 0. Directly assign the requested value (h).
+        side = in.h;
+
+    return side;
+}
+
+//-----------------------------------------------------------------------------
+// LIMITS:
+//-----------------------------------------------------------------------------
+
+// Default input: smooth sphere, no motion parameters, Earth's gravitational parameter
+OrbitPixInput orbitPixInput(double h, double fov, double viewAng, double r, int px)
+{
+    OrbitPixInput in;
+
+    in.h = h;
+    in.fov = fov;
+    in.viewAng = viewAng;
+    in.r = r;
+    in.px = px;
+    in.dem = NULL;
+    in.motion = false;
+    in.intTime = 0;
+    in.mu = MU_EARTH;
+    in.maxThreads = 0;
+
+    return in;
+}
+
+// Find the max allowed fov angle (when the fov angle sides gets tangent to the Earth's surface)
+double orbitPixMaxFov(double h, double r)
+{
+    return 2 * sinLawAng(r + h, r, PI / 2);
+}
+
+// Find the max allowed angle (when the external side of fov angle gets tangent to the Earth's surface)
+double orbitPixMaxViewAng(double h, double fov, double r)
+{
+    return orbitPixMaxFov(h, r) / 2 - fov / 2;
+}
+
+// Check if the number of pixels, fov or view angle is out of the allowed range
+static bool checkCond(const OrbitPixInput &in, OrbitPixResult &res)
+{
+    res.maxFov = orbitPixMaxFov(in.h, in.r);
+    res.maxViewAng = orbitPixMaxViewAng(in.h, in.fov, in.r);
+    res.err = ERR_NONE;
+
+    // The negated comparisons also catch nan (and inf by the max values)
+    if (!(in.h > 0 && in.h < INFINITY))
+    {
+        res.err = ERR_H;
+        res.errMsg = "Altitude must be positive";
+    }
+
+    else if (!(in.r > 0 && in.r < INFINITY))
+    {
+        res.err = ERR_R;
+        res.errMsg = "Radius must be positive";
+    }
+
+    else if (in.px <= 0)
+    {
+        res.err = ERR_PX;
+        res.errMsg = "Number of pixels must be positive";
+    }
+
+    else if (!(in.fov > 0 && in.fov <= res.maxFov))
+    {
+        res.err = ERR_FOV;
+        res.errMsg = in.fov > 0 ? "Fov angle is greater than the max allowed value" : "Fov angle must be positive";
+    }
+
+    else if (!(fabs(in.viewAng) <= res.maxViewAng))
+    {
+        res.err = ERR_VIEW_ANG;
+        res.errMsg = "View angle is greater than the max allowed value";
+    }
+
+    else if (in.motion && !(in.mu > 0 && in.mu < INFINITY))
+    {
+        res.err = ERR_MU;
+        res.errMsg = "Gravitational parameter must be positive";
+    }
+
+    else if (in.motion && !(in.intTime >= 0 && in.intTime < INFINITY))
+    {
+        res.err = ERR_INT_TIME;
+        res.errMsg = "Integration time can't be negative";
+    }
+
+    return res.err == ERR_NONE;
+}
+
+//-----------------------------------------------------------------------------
+// PER-PIXEL LOOPS:
+//-----------------------------------------------------------------------------
+
+// Pool of worker threads, started on the first parallel calculation and kept until the program exits, so a
+// calculation doesn't pay for creating and joining threads. The calculations of several caller threads share the
+// pool: each one is a job in the queue, and its caller works on it too (so a job always ends, even with no workers).
+class ChunkPool
+{
+
+public:
+
+    static ChunkPool &instance()
+    {
+        static ChunkPool pool; // thread-safe initialization (C++11)
+
+        return pool;
+    }
+
+    // Run chunkFunc(c) for every chunk 0 <= c < nChunks with the caller thread and at most maxHelpers workers
+    void run(int nChunks, int maxHelpers, const function<void(int)> &chunkFunc)
+    {
+        Job job;
+
+        job.func = &chunkFunc;
+        job.nChunks = nChunks;
+        job.nextChunk = 0;
+        job.maxHelpers = min(maxHelpers, (int)workers.size());
+        job.nHelpers = 0;
+        job.nActive = 0;
+
+        if (job.maxHelpers > 0)
+        {
+            lock_guard<mutex> lock(mtx);
+            jobs.push_back(&job);
+            workCond.notify_all();
+        }
+
+        runChunks(job);
+
+        // All the chunks are taken: no more helpers, and wait for the ones still working on their last chunk
+        unique_lock<mutex> lock(mtx);
+        jobs.erase(remove(jobs.begin(), jobs.end(), &job), jobs.end());
+        doneCond.wait(lock, [&]() { return job.nActive == 0; });
+    }
+
+private:
+
+    struct Job
+    {
+        const function<void(int)> *func;
+
+        int nChunks;
+
+        atomic<int> nextChunk;
+
+        int maxHelpers, nHelpers, nActive; // guarded by mtx
+    };
+
+    ChunkPool()
+    {
+        int nWorkers = (int)thread::hardware_concurrency() - 1; // the caller is the other thread
+
+        stop = false;
+        for (int t = 0; t < nWorkers; t++)
+            workers.push_back(thread(&ChunkPool::work, this));
+    }
+
+    ~ChunkPool()
+    {
+        {
+            lock_guard<mutex> lock(mtx);
+            stop = true;
+            workCond.notify_all();
+        }
+        for (size_t t = 0; t < workers.size(); t++)
+            workers[t].join();
+    }
+
+    ChunkPool(const ChunkPool &) = delete;
+
+    ChunkPool &operator=(const ChunkPool &) = delete;
+
+    static void runChunks(Job &job)
+    {
+        int c;
+
+        while ((c = job.nextChunk++) < job.nChunks)
+            (*job.func)(c);
+    }
+
+    void work()
+    {
+        unique_lock<mutex> lock(mtx);
+        Job *job;
+
+        while (true)
+        {
+            workCond.wait(lock, [&]() { return stop || !jobs.empty(); });
+            if (stop)
+                return;
+
+            job = jobs.front();
+            job->nActive++;
+            if (++job->nHelpers >= job->maxHelpers)
+                jobs.pop_front(); // the job has all its helpers
+
+            lock.unlock();
+            runChunks(*job);
+            lock.lock();
+
+            if (--job->nActive == 0)
+                doneCond.notify_all();
+        }
+    }
+
+    mutex mtx;
+
+    condition_variable workCond, doneCond;
+
+    deque<Job *> jobs;
+
+    vector<thread> workers;
+
+    bool stop;
+
+};
+
+// Split [0, n) into chunks of PAR_CHUNK pixels and run chunkFunc(begin, end) on each of them, shared between the
+// caller and the pool threads (at most maxThreads threads in total, 0: no limit). If n is smaller than minN or
+// maxThreads is 1, the caller thread does all the work in a single call.
+template <typename F>
+static void parallelChunks(int n, int minN, int maxThreads, F chunkFunc)
+{
+    int nChunks = (n + PAR_CHUNK - 1) / PAR_CHUNK;
+    int maxHelpers = nChunks - 1;
+
+    if (n < minN || maxThreads == 1)
+    {
+        chunkFunc(0, n);
+        return;
+    }
+
+    if (maxThreads > 1 && maxHelpers > maxThreads - 1)
+        maxHelpers = maxThreads - 1;
+
+    ChunkPool::instance().run(nChunks, maxHelpers,
+                              [&](int c) { chunkFunc(c * PAR_CHUNK, min(n, (c + 1) * PAR_CHUNK)); });
+}
+
+// Calculate the (centered) line of sight for the pixels [begin, end).
+static void losChunkCalc(const OrbitPixInput &in, double dViewAng, OrbitPixResult &res, int begin, int end)
+{
+    double ang_1, x, y, angVel, grndVel, alongPix;
+
+    angVel = sqrt(in.mu / (in.r + in.h)) / (in.r + in.h); // angular velocity of the orbit
+
+    for (int i = begin; i < end; i++)
+    {
+        ang_1 = in.viewAng + (in.fov / 2) - (i + 1) * dViewAng + (dViewAng / 2);
+        if (in.dem)
+        {
+            if (!in.dem->rayHit(ang_1, in.r, in.h, &res.losVec[i], &x, &y))
+                res.losVec[i] = NAN; // the ray misses the planet (rounding at the horizon)
+        }
+        else if (ang_1)
+            res.losVec[i] = strtLineLenCalc(ang_1, in.r, in.h); // in each step, store the calculated line of sight
+        else // do not use the law of sines when the angle_1 is equal to 0 (nadir)
+            res.losVec[i] = in.h;
+        res.angVec[i] = ang_1; // in each step, store the angle used
+
+        if (in.motion)
+        {
+            // The ground point rotates (with the orbit) around the across-track axis through the planet centre,
+            // so its along-track velocity is proportional to its distance from that axis.
+            grndVel = angVel * (in.r + in.h - res.losVec[i] * cos(ang_1));
+            alongPix = 2 * res.losVec[i] * tan(dViewAng / 2); // square pixels: the along-track ifov is dViewAng
+            res.alongPixVec[i] = alongPix;
+            res.grndVelVec[i] = grndVel;
+            res.lineRateVec[i] = grndVel / alongPix;
+            res.smearVec[i] = grndVel * in.intTime / alongPix;
+        }
+    }
+}
+
+// Calculate the size of the pixels [begin, end) and the sides of their angles. The side at the end of the chunk is
+// shared with the next chunk: it is calculated by both, but stored only by the chunk that starts with it.
+static void pixSizeChunkCalc(const OrbitPixInput &in, double dViewAng, OrbitPixResult &res, int begin, int end)
+{
+    double side_1, side_2, crd, theta;
+
+    side_1 = dAngSideCalc(in, dViewAng, begin);
+    for (int i = begin; i < end; i++)
+    {
+        side_2 = dAngSideCalc(in, dViewAng, i + 1);
+        crd = cosLaw(side_1, side_2, dViewAng);
+        theta = 2 * asin(crd / (2 * in.r));
+        res.pixVec[i] = in.r * theta;
+        res.dAngSidesVec[i] = side_1;
+        side_1 = side_2;
+    }
+
+    if (end == in.px) // the last chunk stores the last side too
+        res.dAngSidesVec[in.px] = side_1;
+}
+
+// Same as pixSizeChunkCalc(), with the sides ending on the terrain. The size of each pixel is the (straight) distance
+// between the terrain points of its sides, so it includes the effect of the slope.
+static void terrainPixSizeChunkCalc(const OrbitPixInput &in, double dViewAng, OrbitPixResult &res, int begin, int end)
+{
+    double ang_1, side, x_1 = 0, y_1 = 0, x_2, y_2;
+
+    for (int i = begin; i <= end; i++)
+    {
+        ang_1 = in.viewAng + in.fov / 2 - i * dViewAng;
+        if (!in.dem->rayHit(ang_1, in.r, in.h, &side, &x_2, &y_2))
+            side = x_2 = y_2 = NAN; // the ray misses the planet (rounding at the horizon)
+        if (i < end || end == in.px) // the side at the end of the chunk is stored by the next chunk
+            res.dAngSidesVec[i] = side;
+        if (i > begin)
+            res.pixVec[i-1] = hypot(x_2 - x_1, y_2 - y_1);
+        x_1 = x_2;
+        y_1 = y_2;
+    }
+}
+
+// Calculate the line of sight and the size of each pixel together with their partial derivatives with respect to
+// h, fov, view angle and r (see SensParam). Forward-mode automatic differentiation is used, so a single pass gives
+// the values (same as CALC_LOS and CALC_SIZE) and all the derivatives. The derivatives of the lines are taken from
+// rootLineLenCalc(), which is well conditioned at nadir. The terrain is not used here.
+static void sensCalc(const OrbitPixInput &in, OrbitPixResult &res)
+{
+    int px = in.px;
+    vector<SensDual> sides(px + 1);
+    SensDual hD, fovD, viewAngD, rD, dViewAngD, ang_1, los, crd, pix;
+
+    hD = SensDual::var(in.h, SENS_H);
+    fovD = SensDual::var(in.fov, SENS_FOV);
+    viewAngD = SensDual::var(in.viewAng, SENS_VIEWANG);
+    rD = SensDual::var(in.r, SENS_R);
+    dViewAngD = fovD / (double)px;
+
+    res.losVec.resize(px);
+    res.angVec.resize(px);
+    res.pixVec.resize(px);
+    res.dAngSidesVec.resize(px + 1);
+    for (int k = 0; k < SENS_NPARAMS; k++)
+    {
+        res.losSensVec[k].resize(px);
+        res.pixSensVec[k].resize(px);
+    }
+
+    // Line of sight
+    for (int i = 0; i < px; i++)
+    {
+        ang_1 = viewAngD + fovD / 2.0 - (i + 1) * dViewAngD + dViewAngD / 2.0;
+        los = rootLineLenCalc(ang_1, rD, hD);
+        los.val = ang_1.val ? strtLineLenCalc(ang_1.val, in.r, in.h) : in.h; // same value as losChunkCalc()
+        res.losVec[i] = los.val;
+        res.angVec[i] = ang_1.val;
+        for (int k = 0; k < SENS_NPARAMS; k++)
+            res.losSensVec[k][i] = los.der[k];
+    }
+
+    // Sides of the pixel angles (same as dAngSideCalc())
+    for (int i = 0; i <= px; i++)
+    {
+        ang_1 = viewAngD + fovD / 2.0 - i * dViewAngD;
+        sides[i] = rootLineLenCalc(ang_1, rD, hD);
+        sides[i].val = ang_1.val ? strtLineLenCalc(ang_1.val, in.r, in.h) : in.h;
+        res.dAngSidesVec[i] = sides[i].val;
+    }
+
+    // Pixel size
+    for (int i = 0; i < px; i++)
+    {
+        crd = cosLaw(sides[i], sides[i+1], dViewAngD);
+        pix = rD * (2.0 * asin(crd / (2.0 * rD)));
+        res.pixVec[i] = pix.val;
+        for (int k = 0; k < SENS_NPARAMS; k++)
+            res.pixSensVec[k][i] = pix.der[k];
+    }
+}
+
+//-----------------------------------------------------------------------------
+// CALCULATION:
+//-----------------------------------------------------------------------------
+
+OrbitPixResult orbitPixCalc(const OrbitPixInput &in, int flags)
+{
+    OrbitPixResult res;
+    double dViewAng;
+
+    if (!checkCond(in, res))
+        return res;
+
+    dViewAng = in.fov / in.px; // the angle step
+
+    if (flags & CALC_SENS)
+    {
+        sensCalc(in, res);
+        return res;
+    }
+
+    if (flags & CALC_LOS)
+    {
+        res.losVec.resize(in.px);
+        res.angVec.resize(in.px);
+        if (in.motion)
+        {
+            res.alongPixVec.resize(in.px);
+            res.grndVelVec.resize(in.px);
+            res.lineRateVec.resize(in.px);
+            res.smearVec.resize(in.px);
+        }
+        parallelChunks(in.px, in.dem ? PAR_MIN_PX_DEM : PAR_MIN_PX, in.maxThreads,
+                       [&](int begin, int end) { losChunkCalc(in, dViewAng, res, begin, end); });
+    }
+
+    if (flags & CALC_SIZE)
+    {
+        res.pixVec.resize(in.px);
+        res.dAngSidesVec.resize(in.px + 1);
+        if (in.dem)
+            parallelChunks(in.px, PAR_MIN_PX_DEM, in.maxThreads,
+                           [&](int begin, int end) { terrainPixSizeChunkCalc(in, dViewAng, res, begin, end); });
+        else
+            parallelChunks(in.px, PAR_MIN_PX, in.maxThreads,
+                           [&](int begin, int end) { pixSizeChunkCalc(in, dViewAng, res, begin, end); });
+    }
+
+    return res;
+}
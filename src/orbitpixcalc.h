@@ -0,0 +1,71 @@
+#ifndef OrbitPixCalc_H
+#define OrbitPixCalc_H
+
+#include <string>
+#include <vector>
+#include "demterrain.h"
+
+using namespace std;
+
+#define MU_EARTH 398600.4418 // Earth's gravitational parameter (km^3/s^2)
+
+// Input parameters for the sensitivity (partial derivatives) calculation
+enum SensParam { SENS_H, SENS_FOV, SENS_VIEWANG, SENS_R, SENS_NPARAMS };
+
+// What orbitPixCalc() calculates (the flags can be combined)
+enum OrbitPixCalcFlags
+{
+    CALC_LOS = 1, // angle and line of sight of each pixel (and the along-track motion parameters, if requested)
+    CALC_SIZE = 2, // size of each pixel and sides of the pixel angles
+    CALC_SENS = 4 // line of sight, size, sides and their partial derivatives (smooth sphere, no motion parameters)
+};
+
+enum OrbitPixErr { ERR_NONE, ERR_H, ERR_R, ERR_PX, ERR_FOV, ERR_VIEW_ANG, ERR_MU, ERR_INT_TIME };
+
+// Input parameters (angles in rad, lengths in km)
+struct OrbitPixInput
+{
+    double h, fov, viewAng, r;
+
+    int px;
+
+    const DemTerrain *dem; // terrain (NULL: smooth sphere of radius r), not owned
+
+    bool motion; // calculate the along-track motion parameters
+
+    double intTime; // integration time of a line (s, >= 0, checked only with motion)
+
+    double mu; // gravitational parameter of the planet (km^3/s^2, > 0, checked only with motion)
+
+    int maxThreads; // max threads of the calculation (0: all the cores, 1: only the caller thread)
+};
+
+// Results of a calculation. The vectors not requested by the flags (or all, if err != ERR_NONE) are empty.
+// With a DEM, the values of a ray that misses the planet (rounding at the horizon) are nan.
+struct OrbitPixResult
+{
+    OrbitPixErr err;
+
+    string errMsg;
+
+    double maxFov, maxViewAng;
+
+    vector<double> angVec, losVec, dAngSidesVec, pixVec;
+
+    vector<double> alongPixVec, grndVelVec, lineRateVec, smearVec;
+
+    vector<double> losSensVec[SENS_NPARAMS], pixSensVec[SENS_NPARAMS];
+};
+
+// The functions below don't keep any state, so they can be called concurrently from many threads
+// (the DEM of the input is only read, and the calls share a thread pool for the parallel loops).
+
+OrbitPixInput orbitPixInput(double h, double fov, double viewAng, double r, int px);
+
+double orbitPixMaxFov(double h, double r);
+
+double orbitPixMaxViewAng(double h, double fov, double r);
+
+OrbitPixResult orbitPixCalc(const OrbitPixInput &in, int flags = CALC_LOS | CALC_SIZE);
+
+#endif // OrbitPixCalc_H
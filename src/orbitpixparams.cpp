@@ -7,159 +7,98 @@
 
 OrbitPixParams::OrbitPixParams(double h, double fov, double viewAng, double r, int px)
 {
-    this->h = h;
-    this->fov = fov;
-    this->viewAng = viewAng;
-    this->r = r;
-    this->px = px;
-    dViewAng = fov / px; // calculate and set the angle step
-    maxFovCalc(); // calculate and set the max allowed value for the fov angle
-    maxViewAngCalc(); // calculate and set the max allowed value for the view angle
+    in = orbitPixInput(h, fov, viewAng, r, px); // smooth sphere, no motion parameters, Earth
+    errH = false; // error flag for the altitude
+    errR = false; // error flag for the radius
+    errPx = false; // error flag for the number of pixels
     errViewAng = false; // error flag for view angle
     errFov = false; // // error flag for fov angle
+    errMu = false; // error flag for the gravitational parameter (motion)
+    errIntTime = false; // error flag for the integration time (motion)
 }
 
 //-----------------------------------------------------------------------------
 // CALC METHODS:
 //-----------------------------------------------------------------------------
 
-// Law of sines, case 1: two sides and one non-enclosed angle are known, calculate the oposite angle of side_2.
-double OrbitPixParams::sinLawAng(double side_1, double side_2, double angle_1)
+// Set the error flags from a result (they describe only the last calculation). When it failed, the vectors of the
+// previous calculations are cleared too, so the getters and printToFile() don't give results of another configuration.
+bool OrbitPixParams::setResult(OrbitPixResult &res)
 {
-    double angle_2;
-
-    angle_2 = asin((side_2) * sin(angle_1) / side_1);
-
-    return angle_2;
-}
-
-// Law of sines, case 2: two angles and a side are known, calculate the oposite side of angle_2.
-double OrbitPixParams::sinLawSide(double angle_1, double angle_2, double side_1)
-{
-    double side_2;
-
-    side_2 = side_1 * sin(angle_2) / sin(angle_1);
-
-    return side_2;
-}
-
-// Law of cosines: two sides and the enclosed angle are known, calculate the third side.
-double OrbitPixParams::cosLaw(double side_1, double side_2, double angle)
-{
-    double side_3;
-
-    side_3 = sqrt(pow(side_1, 2) + pow(side_2, 2) - 2 * side_1 * side_2 * cos(angle));
-
-    return side_3;
-}
-
-// Find the max allowed fov angle (when the fov angle sides gets tangent to the Earth's surface)
-void OrbitPixParams::maxFovCalc()
-{
-    double side_1, side_2, angle_1;
-    side_1 = r + h;
-    side_2 = r;
-    angle_1 = PI / 2;
-    maxFov = 2 * sinLawAng(side_1, side_2, angle_1);
-}
-
-// Find the max allowed angle (when the external side of fov angle gets tangent to the Earth's surface)
-void OrbitPixParams::maxViewAngCalc()
-{
-    maxViewAng = maxFov / 2 - fov / 2;
-}
-
-// Check if fov or view angle is out of the allowed range
-bool OrbitPixParams::checkCond()
-{
-    bool ok = true;
-
-    if (fov > maxFov)
-    {
-        errFov = true;
-        errMsg = "Fov angle is greater than the max allowed value";
-        ok = false;
-    }
-
-    else if (fabs(viewAng) > maxViewAng)
+    errH = res.err == ERR_H;
+    errR = res.err == ERR_R;
+    errPx = res.err == ERR_PX;
+    errFov = res.err == ERR_FOV;
+    errViewAng = res.err == ERR_VIEW_ANG;
+    errMu = res.err == ERR_MU;
+    errIntTime = res.err == ERR_INT_TIME;
+    errMsg = res.errMsg;
+
+    if (res.err != ERR_NONE)
     {
-        errViewAng = true;
-        errMsg = "View angle is greater than the max allowed value";
-        ok = false;
+        angVec.clear();
+        losVec.clear();
+        dAngSidesVec.clear();
+        pixVec.clear();
+        alongPixVec.clear();
+        grndVelVec.clear();
+        lineRateVec.clear();
+        smearVec.clear();
+        for (int k = 0; k < SENS_NPARAMS; k++)
+        {
+            losSensVec[k].clear();
+            pixSensVec[k].clear();
+        }
     }
 
-    return ok;
+    return res.err == ERR_NONE;
 }
 
-// Calculate the length of a straight line, starting from the satellite and ending on the planet's surface (/| when this angle is given).
-double OrbitPixParams::strtLineLenCalc(double ang_1)
-{
-    double ang_2, ang_3, lineLen;
-
-    ang_2 = 2 * PI - sinLawAng(r, r + h, ang_1);
-    ang_3 = 2 * PI - ang_1 - ang_2;
-    lineLen = sinLawSide(ang_1, ang_3, r);
-
-    return lineLen;
-}
-
-// Calculate the lenth of all sides of the angles resulting after the segmetation of the fov into px parts.
-void OrbitPixParams::dAngSidesCalc()
+// Calculate the (centered) line of sight for each pixel.
+void OrbitPixParams::losCalc()
 {
-    vector<double> dAngSidesVec(px + 1);
-    double ang_1;
+    OrbitPixResult res = orbitPixCalc(in, CALC_LOS);
 
-    for (int i = 0; i <= px; i++)
+    if (setResult(res))
     {
-        ang_1 = viewAng + fov / 2 - i * dViewAng;
-        if (ang_1)
-            dAngSidesVec[i] = strtLineLenCalc(ang_1);
-        else // do not use the law of sines when the angle_1 is equal to 0. Directly assign the requested value (h) to the vector.
-            dAngSidesVec[i] = h;
+        losVec.swap(res.losVec);
+        angVec.swap(res.angVec);
+        alongPixVec.swap(res.alongPixVec);
+        grndVelVec.swap(res.grndVelVec);
+        lineRateVec.swap(res.lineRateVec);
+        smearVec.swap(res.smearVec);
     }
-
-    this->dAngSidesVec = dAngSidesVec;
 }
 
-// Calculate the (centered) line of sight for each pixel.
-void OrbitPixParams::losCalc()
+// Calculate the size of each pixel (and the sides of all pixel angles).
+void OrbitPixParams::pixSizeCalc()
 {
-    vector<double> losVec(px);
-    vector<double> angVec(px);
-    double ang_1;
+    OrbitPixResult res = orbitPixCalc(in, CALC_SIZE);
 
-    if (checkCond())
+    if (setResult(res))
     {
-        //side_1 = r;
-        //side_2 = r + h;
-        for (int i = 0; i < px; i++)
-        {
-            ang_1 = viewAng + (fov / 2) - (i + 1) * dViewAng + (dViewAng / 2);
-            losVec[i] = strtLineLenCalc(ang_1); // in each step, store the calculated line of sight
-            angVec[i] = ang_1; // in each step, store the angle used
-        }
-        this->losVec = losVec;
-        this->angVec = angVec;
+        pixVec.swap(res.pixVec);
+        dAngSidesVec.swap(res.dAngSidesVec);
     }
 }
 
-
-void OrbitPixParams::pixSizeCalc()
+// Calculate the line of sight and the size of each pixel together with their partial derivatives with respect to
+// h, fov, view angle and r (see SensParam). The terrain (setDem()) is not used here.
+void OrbitPixParams::sensCalc()
 {
-    vector<double> pixVec(px);
-    double crd, theta;
+    OrbitPixResult res = orbitPixCalc(in, CALC_SENS);
 
-    if (checkCond())
+    if (setResult(res))
     {
-        dAngSidesCalc();
-        for (int i = 0; i < px; i++)
+        losVec.swap(res.losVec);
+        angVec.swap(res.angVec);
+        pixVec.swap(res.pixVec);
+        dAngSidesVec.swap(res.dAngSidesVec);
+        for (int k = 0; k < SENS_NPARAMS; k++)
         {
-            crd = cosLaw(dAngSidesVec[i], dAngSidesVec[i+1], dViewAng);
-            theta = 2 * asin(crd / (2 * r));
-            pixVec[i] = r * theta;
+            losSensVec[k].swap(res.losSensVec[k]);
+            pixSensVec[k].swap(res.pixSensVec[k]);
         }
-
-        this->pixVec = pixVec;
     }
 }
 
@@ -169,41 +108,80 @@ void OrbitPixParams::pixSizeCalc()
 
 void OrbitPixParams::setH(double h)
 {
+    errH = false;
+    errR = false;
+    errPx = false;
     errFov = false;
     errViewAng = false;
-    this->h = h;
-    maxFovCalc(); // when the h changes, recalculate the max allowed fov angle
-    maxViewAngCalc(); // ...and the max allowed view angle
+    in.h = h;
 }
 
 void OrbitPixParams::setFov(double fov)
 {
+    errH = false;
+    errR = false;
+    errPx = false;
     errFov = false;
     errViewAng = false;
-    this->fov = fov;
-    dViewAng = fov / px; // when the fov changes, recalculate the dViewAng
+    in.fov = fov;
 }
 
 void OrbitPixParams::setAng(double viewAng)
 {
+    errH = false;
+    errR = false;
+    errPx = false;
     errFov = false;
     errViewAng = false;
-    this->viewAng = viewAng;
+    in.viewAng = viewAng;
 }
 
 void OrbitPixParams::setR(double r)
 {
+    errH = false;
+    errR = false;
+    errPx = false;
     errFov = false;
     errViewAng = false;
-    this->r = r;
-    maxFovCalc(); // when the r changes, recalculate the max allowed fov angle
-    maxViewAngCalc(); // ... and the max allowed view angle
+    in.r = r;
+}
+
+// Intersect the lines of sight with the terrain of a DEM (NULL: smooth sphere of radius r). The DEM is not owned.
+void OrbitPixParams::setDem(const DemTerrain *dem)
+{
+    in.dem = dem;
+}
+
+// Calculate also the along-track motion parameters of each pixel in losCalc() (push-broom sensors)
+void OrbitPixParams::setMotion(bool motion)
+{
+    errMu = false;
+    errIntTime = false;
+    in.motion = motion;
+}
+
+// Integration time of a line (s)
+void OrbitPixParams::setIntTime(double intTime)
+{
+    errIntTime = false;
+    in.intTime = intTime;
+}
+
+// Gravitational parameter of the planet (km^3/s^2), Earth by default
+void OrbitPixParams::setMu(double mu)
+{
+    errMu = false;
+    in.mu = mu;
 }
 
 void OrbitPixParams::setPx(double px)
 {
-    this->px = px;
-    dViewAng = fov / px; // when the number of pixels changes, recalculate the dViewAng
+    errH = false;
+    errR = false;
+    errPx = false;
+    errFov = false;
+    errViewAng = false;
+    in.px = px;
 }
 
 //-----------------------------------------------------------------------------
@@ -212,12 +190,27 @@ void OrbitPixParams::setPx(double px)
 
 double OrbitPixParams::getmaxViewAng()
 {
-    return maxViewAng;
+    return orbitPixMaxViewAng(in.h, in.fov, in.r);
 }
 
 double OrbitPixParams::getMaxFov()
 {
-    return maxFov;
+    return orbitPixMaxFov(in.h, in.r);
+}
+
+bool OrbitPixParams::getErrH()
+{
+    return errH;
+}
+
+bool OrbitPixParams::getErrR()
+{
+    return errR;
+}
+
+bool OrbitPixParams::getErrPx()
+{
+    return errPx;
 }
 
 bool OrbitPixParams::getErrFov()
@@ -230,6 +223,22 @@ bool OrbitPixParams::getErrViewAng()
     return errViewAng;
 }
 
+bool OrbitPixParams::getErrMu()
+{
+    return errMu;
+}
+
+bool OrbitPixParams::getErrIntTime()
+{
+    return errIntTime;
+}
+
+// Any of the errors above
+bool OrbitPixParams::getErr()
+{
+    return errH || errR || errPx || errFov || errViewAng || errMu || errIntTime;
+}
+
 string OrbitPixParams::getErrMsg()
 {
     return errMsg;
@@ -255,6 +264,58 @@ vector<double> OrbitPixParams::getAngVec()
     return angVec;
 }
 
+// Velocity of the satellite (km/s), circular orbit
+double OrbitPixParams::getOrbVel()
+{
+    return sqrt(in.mu / (in.r + in.h));
+}
+
+// Along-track size of each pixel (km)
+vector<double> OrbitPixParams::getAlongPixVec()
+{
+    return alongPixVec;
+}
+
+// Along-track velocity of the ground point of each pixel (km/s)
+vector<double> OrbitPixParams::getGrndVelVec()
+{
+    return grndVelVec;
+}
+
+// Line rate (lines/s) for contiguous along-track sampling of each pixel
+vector<double> OrbitPixParams::getLineRateVec()
+{
+    return lineRateVec;
+}
+
+// Motion smear during the integration time (pixels) of each pixel
+vector<double> OrbitPixParams::getSmearVec()
+{
+    return smearVec;
+}
+
+// Max line rate of all pixels (the sensor's line rate must be at least this)
+double OrbitPixParams::getMaxLineRate()
+{
+    double maxRate = 0;
+
+    for (size_t i = 0; i < lineRateVec.size(); i++)
+        if (lineRateVec[i] > maxRate)
+            maxRate = lineRateVec[i];
+
+    return maxRate;
+}
+
+vector<double> OrbitPixParams::getLosSensVec(SensParam param)
+{
+    return losSensVec[param];
+}
+
+vector<double> OrbitPixParams::getPixSensVec(SensParam param)
+{
+    return pixSensVec[param];
+}
+
 
 //-----------------------------------------------------------------------------
 // PRINT TO FILE:
@@ -275,7 +336,7 @@ bool OrbitPixParams::printToFile(string fileName, string angMeas)
         angPr = angSs.str();
         fprintf(f, "%s \t %s \t %s \t %s \n", "pixel", angPr.c_str(), "LoS (km)", "Size (m)");
         fprintf(f, "%s \n", "-------------------------------------------------");
-        for (int i = 0; i < px; i++)
+        for (size_t i = 0; i < losVec.size() && i < pixVec.size(); i++) // the vectors of the last calculations
         {
             if (angMeas == "rad")
                 angi = angVec[i];
@@ -284,7 +345,7 @@ bool OrbitPixParams::printToFile(string fileName, string angMeas)
             else if (angMeas == "grad")
                 angi = 200 * angVec[i] / PI;
 
-            fprintf(f, "%d \t %4.4f \t %4.4f \t %4.2f \n", i + 1, angi, losVec[i], pixVec[i] * 1000);
+            fprintf(f, "%d \t %4.4f \t %4.4f \t %4.2f \n", (int)i + 1, angi, losVec[i], pixVec[i] * 1000);
         }
 
         fclose(f);
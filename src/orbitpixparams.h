@@ -6,9 +6,12 @@
 #include <sstream>
 #include <math.h>
 #include <vector>
+#include "orbitpixcalc.h"
 
 using namespace std;
 
+// Calculation state kept between the calls of the GUI (a thin wrapper of orbitPixCalc(), which doesn't keep any state).
+// An object must not be used from more than one thread at a time.
 class OrbitPixParams
 {
 
@@ -20,6 +23,8 @@ public:
 
     void pixSizeCalc();
 
+    void sensCalc();
+
     void setH(double h);
 
     void setFov(double fov);
@@ -30,14 +35,34 @@ public:
 
     void setPx(double px);
 
+    void setDem(const DemTerrain *dem);
+
+    void setMotion(bool motion);
+
+    void setIntTime(double intTime);
+
+    void setMu(double mu);
+
     double getmaxViewAng();
 
     double getMaxFov();
 
+    bool getErrH();
+
+    bool getErrR();
+
+    bool getErrPx();
+
     bool getErrFov();
 
     bool getErrViewAng();
 
+    bool getErrMu();
+
+    bool getErrIntTime();
+
+    bool getErr();
+
     string getErrMsg();
 
     vector<double> getPixVec();
@@ -48,36 +73,40 @@ public:
 
     vector<double> getAngVec();
 
-    bool printToFile(string fileName, string angMeas);
+    double getOrbVel();
 
-private:
+    vector<double> getAlongPixVec();
 
-    double sinLawAng(double side_1, double side_2, double angle_1);
+    vector<double> getGrndVelVec();
 
-    double sinLawSide(double angle_1, double angle_2, double side_1);
+    vector<double> getLineRateVec();
 
-    double cosLaw(double side_1, double side_2, double angle);
+    vector<double> getSmearVec();
 
-    double strtLineLenCalc(double ang_1);
+    double getMaxLineRate();
 
-    void dAngSidesCalc();
+    vector<double> getLosSensVec(SensParam param);
 
-    void maxFovCalc();
+    vector<double> getPixSensVec(SensParam param);
 
-    void maxViewAngCalc();
+    bool printToFile(string fileName, string angMeas);
 
-    bool checkCond();
+private:
 
-    bool errViewAng, errFov;
+    bool setResult(OrbitPixResult &res);
 
-    string errMsg;
+    bool errH, errR, errPx, errViewAng, errFov, errMu, errIntTime;
 
-    int px;
+    string errMsg;
 
-    double h, fov, viewAng, r, maxFov, maxViewAng, dViewAng;
+    OrbitPixInput in;
 
     vector<double> angVec, dAngSidesVec, losVec, pixVec;
 
+    vector<double> alongPixVec, grndVelVec, lineRateVec, smearVec;
+
+    vector<double> losSensVec[SENS_NPARAMS], pixSensVec[SENS_NPARAMS];
+
 };
 
 #endif // OrbitPixParams_H
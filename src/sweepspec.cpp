@@ -0,0 +1,454 @@
+#include "sweepspec.h"
+#include <fstream>
+#include <set>
+#include <stdlib.h>
+#define PI 3.141592653589793
+
+static const char *paramNames[] = {"h", "fov", "viewAng", "r", "px"};
+
+// Output format of the parameters: all the significant digits of a double that a decimal value keeps, so the rows
+// of fine-step sweeps stay distinct
+static const char *paramFormats[] = {"%.15g", "%.15g", "%.15g", "%.15g", "%.0f"};
+
+static const char *reducerNames[] = {"min", "max", "mean", "first", "last", "center"};
+
+// Name, output scale and output format of the quantities (see SweepSpec::Quantity)
+static const char *qtyNames[] = {"los", "size", "along", "vel", "linerate", "smear"};
+
+static const double qtyScales[] = {1, 1000, 1000, 1, 1, 1};
+
+static const char *qtyFormats[] = {"%.4f", "%.2f", "%.2f", "%.4f", "%.2f", "%.4f"};
+
+// Remove the leading and trailing white space
+static string trim(string s)
+{
+    size_t first = s.find_first_not_of(" \t\r\n");
+    size_t last = s.find_last_not_of(" \t\r\n");
+
+    return first == string::npos ? "" : s.substr(first, last - first + 1);
+}
+
+// Split at the commas (and trim the parts)
+static vector<string> split(string s)
+{
+    vector<string> parts;
+    stringstream ss(s);
+    string part;
+
+    while (getline(ss, part, ','))
+        parts.push_back(trim(part));
+
+    return parts;
+}
+
+static bool toDouble(string s, double *val)
+{
+    char *end;
+
+    *val = strtod(s.c_str(), &end);
+
+    return !s.empty() && *end == '\0';
+}
+
+//-----------------------------------------------------------------------------
+// CONSTRUCTORS:
+//-----------------------------------------------------------------------------
+
+SweepSpec::SweepSpec()
+{
+    for (int p = 0; p < NPARAMS; p++)
+    {
+        params[p].start = 0;
+        params[p].step = 0;
+        params[p].n = 0;
+    }
+    fovUnit = "deg";
+    angUnit = "deg";
+    sep = '\t';
+    intTime = 0;
+    mu = MU_EARTH;
+}
+
+//-----------------------------------------------------------------------------
+// LOAD:
+//-----------------------------------------------------------------------------
+
+bool SweepSpec::load(string fileName)
+{
+    ifstream file(fileName.c_str());
+    string line, key, val;
+    set<string> keys;
+    size_t eq;
+    int lineNum = 0;
+    bool found;
+
+    if (!file)
+    {
+        errMsg = "Can't open the sweep spec file";
+        return false;
+    }
+
+    while (getline(file, line))
+    {
+        lineNum++;
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty())
+            continue;
+
+        eq = line.find('=');
+        if (eq == string::npos)
+        {
+            errMsg = "Line " + to_string(lineNum) + ": expected key = value";
+            return false;
+        }
+        key = trim(line.substr(0, eq));
+        val = trim(line.substr(eq + 1));
+        if (!keys.insert(key).second)
+        {
+            errMsg = "Line " + to_string(lineNum) + ": " + key + " is given twice";
+            return false;
+        }
+
+        found = false;
+        for (int p = 0; p < NPARAMS; p++)
+            if (key == paramNames[p])
+            {
+                found = true;
+                if (!parseValues(val, &params[p]))
+                {
+                    errMsg = "Line " + to_string(lineNum) + ": invalid values of " + key;
+                    return false;
+                }
+            }
+
+        if (found)
+            continue;
+        else if (key == "fovUnit" || key == "angUnit")
+        {
+            if (val != "rad" && val != "deg" && val != "grad")
+            {
+                errMsg = "Line " + to_string(lineNum) + ": the angle unit must be rad, deg or grad";
+                return false;
+            }
+            (key == "fovUnit" ? fovUnit : angUnit) = val;
+        }
+        else if (key == "intTime" || key == "mu")
+        {
+            if (!toDouble(val, key == "intTime" ? &intTime : &mu) || !(intTime >= 0 && intTime < INFINITY)
+                    || !(mu > 0 && mu < INFINITY))
+            {
+                errMsg = "Line " + to_string(lineNum) + ": invalid value of " + key
+                        + (key == "intTime" ? " (must not be negative)" : " (must be positive)");
+                return false;
+            }
+        }
+        else if (key == "format")
+        {
+            if (val != "tsv" && val != "csv")
+            {
+                errMsg = "Line " + to_string(lineNum) + ": the format must be tsv or csv";
+                return false;
+            }
+            sep = val == "csv" ? ',' : '\t';
+        }
+        else if (key == "columns")
+        {
+            if (!parseColumns(val))
+            {
+                errMsg = "Line " + to_string(lineNum) + ": " + errMsg;
+                return false;
+            }
+        }
+        else
+        {
+            errMsg = "Line " + to_string(lineNum) + ": unknown key " + key;
+            return false;
+        }
+    }
+
+    for (int p = 0; p < NPARAMS; p++)
+        if (params[p].n == 0)
+        {
+            errMsg = string("Missing values of ") + paramNames[p];
+            return false;
+        }
+
+    for (long long k = 0; k < params[PAR_H].n; k++)
+        if (!(params[PAR_H].value(k) > 0))
+        {
+            errMsg = "The altitude must be positive";
+            return false;
+        }
+
+    for (long long k = 0; k < params[PAR_R].n; k++)
+        if (!(params[PAR_R].value(k) > 0))
+        {
+            errMsg = "The radius must be positive";
+            return false;
+        }
+
+    for (long long k = 0; k < params[PAR_PX].n; k++)
+        if (params[PAR_PX].value(k) < 1 || params[PAR_PX].value(k) != (int)params[PAR_PX].value(k))
+        {
+            errMsg = "The number of pixels must be a positive integer";
+            return false;
+        }
+
+    if (columns.empty())
+        parseColumns("h, fov, viewAng, r, px, los_min, los_max, size_min, size_max, size_mean");
+
+    return true;
+}
+
+// A list "v1, v2, ..." or a range "start:stop:step"
+bool SweepSpec::parseValues(string val, ParamValues *values)
+{
+    vector<string> parts;
+    double start = 0, stop = 0, step = 0, v;
+
+    values->list.clear();
+    values->n = 0;
+
+    if (val.find(':') != string::npos)
+    {
+        parts.clear();
+        stringstream ss(val);
+        string part;
+        while (getline(ss, part, ':'))
+            parts.push_back(trim(part));
+
+        if (parts.size() != 3 || !toDouble(parts[0], &start) || !toDouble(parts[1], &stop) || !toDouble(parts[2], &step)
+                || step == 0 || (stop - start) / step < 0)
+            return false;
+
+        values->start = start;
+        values->step = step;
+        values->n = (long long)((stop - start) / step + 1e-9) + 1;
+    }
+    else
+    {
+        parts = split(val);
+        for (size_t i = 0; i < parts.size(); i++)
+        {
+            if (!toDouble(parts[i], &v))
+                return false;
+            values->list.push_back(v);
+        }
+        values->n = values->list.size();
+    }
+
+    return values->n > 0;
+}
+
+bool SweepSpec::parseColumns(string val)
+{
+    vector<string> names = split(val);
+    Column col;
+    string qty, red;
+    size_t us;
+    bool found, qtyFound;
+
+    columns.clear();
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        col.name = names[i];
+        col.param = -1;
+        for (int p = 0; p < NPARAMS; p++)
+            if (names[i] == paramNames[p])
+                col.param = p;
+
+        if (col.param < 0)
+        {
+            us = names[i].find('_');
+            qty = names[i].substr(0, us);
+            red = us == string::npos ? "" : names[i].substr(us + 1);
+
+            found = false;
+            for (int k = RED_MIN; k <= RED_CENTER; k++)
+                if (red == reducerNames[k])
+                {
+                    col.reducer = (Reducer)k;
+                    found = true;
+                }
+
+            qtyFound = false;
+            for (int k = QTY_LOS; k < NQTY; k++)
+                if (qty == qtyNames[k])
+                {
+                    col.quantity = (Quantity)k;
+                    qtyFound = true;
+                }
+
+            if (!qtyFound || !found)
+            {
+                errMsg = "unknown column " + names[i];
+                return false;
+            }
+        }
+
+        columns.push_back(col);
+    }
+
+    return !columns.empty();
+}
+
+//-----------------------------------------------------------------------------
+// RUN:
+//-----------------------------------------------------------------------------
+
+// Value k of a list or a range
+double SweepSpec::ParamValues::value(long long k)
+{
+    return list.empty() ? start + k * step : list[k];
+}
+
+double SweepSpec::convToRad(double angle, string measure)
+{
+    double val;
+
+    if (measure == "rad")
+        val = angle;
+    else if (measure == "grad")
+        val = (PI / 200) * angle;
+    else
+        val = (PI / 180) * angle;
+
+    return val;
+}
+
+double SweepSpec::reduce(const vector<double> &vec, Reducer reducer)
+{
+    double val = vec[0];
+
+    switch (reducer)
+    {
+    case RED_MIN:
+        for (size_t i = 1; i < vec.size(); i++)
+            val = vec[i] < val ? vec[i] : val;
+        break;
+    case RED_MAX:
+        for (size_t i = 1; i < vec.size(); i++)
+            val = vec[i] > val ? vec[i] : val;
+        break;
+    case RED_MEAN:
+        for (size_t i = 1; i < vec.size(); i++)
+            val += vec[i];
+        val /= vec.size();
+        break;
+    case RED_FIRST:
+        break;
+    case RED_LAST:
+        val = vec.back();
+        break;
+    case RED_CENTER:
+        val = vec[vec.size() / 2];
+        break;
+    }
+
+    return val;
+}
+
+// Calculate all the configurations and write one line for each (nan for the configurations out of the allowed range)
+bool SweepSpec::run(FILE *f)
+{
+    long long counters[NPARAMS] = {0, 0, 0, 0, 0};
+    long long nConfigs = getNConfigs();
+    double vals[NPARAMS];
+    bool needQty[NQTY] = {false, false, false, false, false, false};
+    bool needLos, needMotion, ok;
+    vector<double> qtyVecs[NQTY];
+    int p;
+
+    for (size_t c = 0; c < columns.size(); c++)
+    {
+        fprintf(f, "%s%c", columns[c].name.c_str(), c + 1 < columns.size() ? sep : '\n');
+        if (columns[c].param < 0)
+            needQty[columns[c].quantity] = true;
+    }
+
+    // the along-track motion parameters are calculated together with the line of sight
+    needMotion = needQty[QTY_ALONG] || needQty[QTY_VEL] || needQty[QTY_LINE_RATE] || needQty[QTY_SMEAR];
+    needLos = needQty[QTY_LOS] || needMotion;
+
+    OrbitPixParams orbitPixParamsObj(params[PAR_H].value(0), convToRad(params[PAR_FOV].value(0), fovUnit),
+                                     convToRad(params[PAR_VIEWANG].value(0), angUnit), params[PAR_R].value(0),
+                                     (int)params[PAR_PX].value(0));
+    orbitPixParamsObj.setMotion(needMotion);
+    orbitPixParamsObj.setIntTime(intTime);
+    orbitPixParamsObj.setMu(mu);
+
+    for (long long k = 0; k < nConfigs; k++)
+    {
+        for (p = 0; p < NPARAMS; p++)
+            vals[p] = params[p].value(counters[p]);
+
+        orbitPixParamsObj.setPx((int)vals[PAR_PX]);
+        orbitPixParamsObj.setFov(convToRad(vals[PAR_FOV], fovUnit));
+        orbitPixParamsObj.setAng(convToRad(vals[PAR_VIEWANG], angUnit));
+        orbitPixParamsObj.setH(vals[PAR_H]);
+        orbitPixParamsObj.setR(vals[PAR_R]);
+
+        if (needLos)
+            orbitPixParamsObj.losCalc();
+        if (needQty[QTY_SIZE])
+            orbitPixParamsObj.pixSizeCalc();
+        ok = !orbitPixParamsObj.getErr();
+        if (ok)
+        {
+            if (needQty[QTY_LOS])
+                qtyVecs[QTY_LOS] = orbitPixParamsObj.getLosVec();
+            if (needQty[QTY_SIZE])
+                qtyVecs[QTY_SIZE] = orbitPixParamsObj.getPixVec();
+            if (needQty[QTY_ALONG])
+                qtyVecs[QTY_ALONG] = orbitPixParamsObj.getAlongPixVec();
+            if (needQty[QTY_VEL])
+                qtyVecs[QTY_VEL] = orbitPixParamsObj.getGrndVelVec();
+            if (needQty[QTY_LINE_RATE])
+                qtyVecs[QTY_LINE_RATE] = orbitPixParamsObj.getLineRateVec();
+            if (needQty[QTY_SMEAR])
+                qtyVecs[QTY_SMEAR] = orbitPixParamsObj.getSmearVec();
+        }
+
+        for (size_t c = 0; c < columns.size(); c++)
+        {
+            if (columns[c].param >= 0)
+                fprintf(f, paramFormats[columns[c].param], vals[columns[c].param]);
+            else if (!ok)
+                fprintf(f, "nan");
+            else
+                fprintf(f, qtyFormats[columns[c].quantity],
+                        reduce(qtyVecs[columns[c].quantity], columns[c].reducer) * qtyScales[columns[c].quantity]);
+
+            fputc(c + 1 < columns.size() ? sep : '\n', f);
+        }
+
+        // next configuration (the last parameter changes fastest)
+        for (p = NPARAMS - 1; p >= 0; p--)
+        {
+            if (++counters[p] < params[p].n)
+                break;
+            counters[p] = 0;
+        }
+    }
+
+    return !ferror(f);
+}
+
+//-----------------------------------------------------------------------------
+// GETTERS:
+//-----------------------------------------------------------------------------
+
+long long SweepSpec::getNConfigs()
+{
+    long long n = 1;
+
+    for (int p = 0; p < NPARAMS; p++)
+        n *= params[p].n;
+
+    return n;
+}
+
+string SweepSpec::getErrMsg()
+{
+    return errMsg;
+}
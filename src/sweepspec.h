@@ -0,0 +1,96 @@
+#ifndef SweepSpec_H
+#define SweepSpec_H
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "orbitpixparams.h"
+
+using namespace std;
+
+// Parametric sweep over h, fov, view angle, r and px, read from a spec file with one "key = value" per line
+// ('#' starts a comment, a key can be given only once; h and r must be positive, px a positive integer):
+//   h = 500:800:50            a range start:stop:step (stop included) or a list of values
+//   fov = 10, 18, 25
+//   viewAng = -30:30:5
+//   r = 6371
+//   px = 640, 1024
+//   fovUnit = deg             rad, deg or grad (default deg), same for angUnit (view angle)
+//   angUnit = deg
+//   columns = h, fov, viewAng, px, size_min, size_max, los_mean
+//   format = tsv              tsv or csv
+//   intTime = 0.0001          integration time of a line (s), for the smear
+//   mu = 398600.4418          gravitational parameter of the planet (km^3/s^2, default Earth)
+// A column is a parameter or <quantity>_<reducer>. The quantities are los (km), size (m), along (along-track size, m),
+// vel (along-track ground velocity, km/s), linerate (lines/s) and smear (pixels) and the reducers
+// min, max, mean, first, last or center (over the pixels of the configuration).
+// The configurations (the Cartesian product of the parameter values, px changing fastest) are generated one by one
+// while the results are written, so the memory used doesn't depend on the number of configurations.
+class SweepSpec
+{
+
+public:
+
+    SweepSpec();
+
+    bool load(string fileName);
+
+    long long getNConfigs();
+
+    string getErrMsg();
+
+    bool run(FILE *f);
+
+private:
+
+    enum Param { PAR_H, PAR_FOV, PAR_VIEWANG, PAR_R, PAR_PX, NPARAMS };
+
+    enum Quantity { QTY_LOS, QTY_SIZE, QTY_ALONG, QTY_VEL, QTY_LINE_RATE, QTY_SMEAR, NQTY };
+
+    enum Reducer { RED_MIN, RED_MAX, RED_MEAN, RED_FIRST, RED_LAST, RED_CENTER };
+
+    struct ParamValues
+    {
+        vector<double> list; // explicit values (empty for a range)
+
+        double start, step;
+
+        long long n;
+
+        double value(long long k);
+    };
+
+    struct Column
+    {
+        string name;
+
+        int param; // -1 for a reduced quantity
+
+        Quantity quantity;
+
+        Reducer reducer;
+    };
+
+    bool parseValues(string val, ParamValues *values);
+
+    bool parseColumns(string val);
+
+    double convToRad(double angle, string measure);
+
+    double reduce(const vector<double> &vec, Reducer reducer);
+
+    string errMsg;
+
+    ParamValues params[NPARAMS];
+
+    string fovUnit, angUnit;
+
+    char sep;
+
+    double intTime, mu;
+
+    vector<Column> columns;
+
+};
+
+#endif // SweepSpec_H
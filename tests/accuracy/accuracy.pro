@@ -0,0 +1,28 @@
+#-------------------------------------------------
+#
+# Accuracy check against the long double reference
+#
+#-------------------------------------------------
+
+QT       += core
+QT       -= gui
+
+CONFIG += c++11 thread console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_accuracy
+TEMPLATE = app
+
+INCLUDEPATH += ../../src
+
+SOURCES += tst_accuracy.cpp \
+    ../../src/accuracycheck.cpp \
+    ../../src/orbitpixcalc.cpp \
+    ../../src/orbitpixparams.cpp \
+    ../../src/demterrain.cpp
+
+HEADERS  += ../../src/accuracycheck.h \
+    ../../src/orbitpixcalc.h \
+    ../../src/orbitpixparams.h \
+    ../../src/dualnum.h \
+    ../../src/demterrain.h
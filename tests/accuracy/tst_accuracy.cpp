@@ -0,0 +1,16 @@
+#include "accuracycheck.h"
+#include <stdlib.h>
+
+#define SENS_TOL 1e-5 // max error of the derivatives, relative (the finite differences of small pixels are noisy)
+
+// tst_accuracy [tolerance in m, default 1 mm]. Exits with 1 if a configuration fails.
+int main(int argc, char *argv[])
+{
+    AccuracyReport report = accuracyCheck(argc > 1 ? atof(argv[1]) : 1e-3);
+    SensReport sensReport = sensCheck(SENS_TOL);
+
+    printAccuracyReport(stdout, report);
+    printSensReport(stdout, sensReport);
+
+    return report.nConfigs > 0 && report.nFailed == 0 && sensReport.nConfigs > 0 && sensReport.nFailed == 0 ? 0 : 1;
+}
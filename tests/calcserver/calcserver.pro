@@ -0,0 +1,26 @@
+#-------------------------------------------------
+#
+# Compute server: batching, cache, stats and request validation (offline, local socket)
+#
+#-------------------------------------------------
+
+QT       += core network concurrent
+QT       -= gui
+
+CONFIG += c++11 thread console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_calcserver
+TEMPLATE = app
+
+INCLUDEPATH += ../../src
+
+SOURCES += tst_calcserver.cpp \
+    ../../src/calcserver.cpp \
+    ../../src/orbitpixcalc.cpp \
+    ../../src/demterrain.cpp
+
+HEADERS  += ../../src/calcserver.h \
+    ../../src/orbitpixcalc.h \
+    ../../src/dualnum.h \
+    ../../src/demterrain.h
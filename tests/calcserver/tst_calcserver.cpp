@@ -0,0 +1,193 @@
+#include "calcserver.h"
+#include <QCoreApplication>
+#include <QLocalSocket>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <stdio.h>
+#include <math.h>
+
+#define TIMEOUT_MS 10000 // max time to wait for the replies
+
+static int nChecks = 0, nFailed = 0;
+
+static void check(bool cond, const char *what)
+{
+    nChecks++;
+    if (!cond)
+    {
+        printf("FAIL: %s\n", what);
+        nFailed++;
+    }
+}
+
+// Client of the server. The server runs in the same thread, so the client keeps the event loop running while it
+// waits for the replies.
+class TestClient
+{
+
+public:
+
+    bool connectTo(QString name)
+    {
+        socket.connectToServer(name);
+
+        return socket.waitForConnected(TIMEOUT_MS);
+    }
+
+    void send(const QByteArray &lines)
+    {
+        socket.write(lines);
+        socket.flush();
+    }
+
+    QList<QJsonObject> receive(int n)
+    {
+        QList<QJsonObject> replies;
+        QElapsedTimer timer;
+
+        timer.start();
+        while (replies.size() < n && timer.elapsed() < TIMEOUT_MS)
+        {
+            QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+            while (socket.canReadLine())
+                replies.append(QJsonDocument::fromJson(socket.readLine()).object());
+        }
+
+        return replies;
+    }
+
+private:
+
+    QLocalSocket socket;
+
+};
+
+static QByteArray calcReq(int id, double h, double fov, double viewAng, double r, double px)
+{
+    QJsonObject obj;
+
+    obj["id"] = id;
+    obj["h"] = h;
+    obj["fov"] = fov;
+    obj["viewAng"] = viewAng;
+    obj["r"] = r;
+    obj["px"] = px;
+
+    return QJsonDocument(obj).toJson(QJsonDocument::Compact) + "\n";
+}
+
+static QByteArray statsReq(int id)
+{
+    return QByteArray("{\"id\": ") + QByteArray::number(id) + ", \"cmd\": \"stats\"}\n";
+}
+
+// Same values as the direct calculation (the JSON numbers keep all the digits of a double)
+static bool sameVec(const QJsonValue &arr, const vector<double> &vec)
+{
+    QJsonArray a = arr.toArray();
+
+    if (a.size() != (int)vec.size())
+        return false;
+    for (int i = 0; i < a.size(); i++)
+        if (fabs(a[i].toDouble() - vec[i]) > 1e-12 * fabs(vec[i]))
+            return false;
+
+    return true;
+}
+
+// tst_calcserver: runs a server on a local socket and checks the batching, the cache, the statistics and the
+// validation of the requests. Exits with 1 if a check fails.
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    CalcServer server;
+    QString name = QString("tst_calcserver_%1").arg(QCoreApplication::applicationPid());
+    OrbitPixResult ref = orbitPixCalc(orbitPixInput(550, 0.3142, 0.2618, 6371, 640));
+    TestClient client_1, client_2;
+    QList<QJsonObject> replies;
+    QHash<int, QJsonObject> byId;
+    QJsonObject stats;
+
+    if (!server.listen(name))
+    {
+        printf("FAIL: can't start the server: %s\n", server.errorString().toStdString().c_str());
+        return 1;
+    }
+    check(client_1.connectTo(name) && client_2.connectTo(name), "the clients connect to the server");
+
+    // Batch: the requests of one write are read together, so they are processed as one batch
+    client_1.send(calcReq(1, 550, 0.3142, 0.2618, 6371, 640) + calcReq(2, 550, 0.3142, 0.2618, 6371, 640)
+                  + calcReq(3, 700, 0.2, -0.1, 6371, 100));
+    replies = client_1.receive(3);
+    check(replies.size() == 3, "a reply for each request of the batch");
+    if (replies.size() == 3)
+    {
+        check(replies[0].value("id").toInt() == 1 && replies[1].value("id").toInt() == 2
+              && replies[2].value("id").toInt() == 3, "the replies keep the order and the ids of the requests");
+        check(replies[0].value("ok").toBool() && replies[1].value("ok").toBool() && replies[2].value("ok").toBool(),
+              "the valid requests succeed");
+        check(sameVec(replies[0].value("los"), ref.losVec) && sameVec(replies[0].value("size"), ref.pixVec)
+              && sameVec(replies[0].value("ang"), ref.angVec), "the results are the same as orbitPixCalc()");
+        check(replies[1].value("los") == replies[0].value("los")
+              && replies[1].value("size") == replies[0].value("size"),
+              "the same configuration in a batch gets the same results");
+        check(replies[2].value("los").toArray().size() == 100, "one value per pixel");
+    }
+
+    client_1.send(statsReq(4));
+    replies = client_1.receive(1);
+    stats = replies.isEmpty() ? QJsonObject() : replies[0];
+    check(stats.value("id").toInt() == 4, "stats reply");
+    check(stats.value("requests").toDouble() == 3, "stats: number of requests");
+    check(stats.value("cacheHits").toDouble() == 0, "stats: no cache hits in the first batch");
+    check(stats.value("batches").toDouble() == 2, "stats: three requests in one batch (and the stats request)");
+
+    // Cache: the results are shared between the clients
+    client_2.send(calcReq(5, 550, 0.3142, 0.2618, 6371, 640));
+    replies = client_2.receive(1);
+    check(replies.size() == 1 && replies[0].value("ok").toBool() && sameVec(replies[0].value("los"), ref.losVec),
+          "a cached configuration from another client");
+
+    client_2.send(statsReq(6));
+    replies = client_2.receive(1);
+    stats = replies.isEmpty() ? QJsonObject() : replies[0];
+    check(stats.value("requests").toDouble() == 5, "stats: number of requests of all the clients");
+    check(stats.value("cacheHits").toDouble() == 1, "stats: cache hit");
+    check(stats.value("p50").toDouble() >= 0 && stats.value("p99").toDouble() >= stats.value("p50").toDouble(),
+          "stats: latencies");
+
+    // Validation: invalid requests get "ok": false (the invalid JSON is replied before the batch)
+    client_1.send(QByteArray("{\"id\": 10, \"fov\": 0.3, \"viewAng\": 0, \"r\": 6371, \"px\": 640}\n")
+                  + "{\"id\": 11, \"h\": \"abc\", \"fov\": 0.3, \"viewAng\": 0, \"r\": 6371, \"px\": 640}\n"
+                  + calcReq(12, 550, 0.3, 0, 6371, 2000000000) + calcReq(13, 550, 0.3, 0, 6371, 0)
+                  + calcReq(14, 550, 0.3, 0, 6371, 1.5) + calcReq(15, 0, 0.3, 0, 6371, 640)
+                  + calcReq(16, 550, 3.0, 0, 6371, 640) + "{\"id\": 17, \"cmd\": \"foo\"}\n" + "not json\n"
+                  + calcReq(19, 550, 0.3, 0, -6371, 640));
+    replies = client_1.receive(10);
+    check(replies.size() == 10, "a reply for each invalid request");
+    for (int i = 0; i < replies.size(); i++)
+        byId[replies[i].contains("id") ? replies[i].value("id").toInt() : 0] = replies[i];
+    check(byId.contains(0) && !byId.value(0).value("ok").toBool(), "invalid JSON");
+    check(byId.contains(10) && !byId.value(10).value("ok").toBool(), "missing h");
+    check(byId.contains(11) && !byId.value(11).value("ok").toBool(), "non-numeric h");
+    check(byId.contains(12) && !byId.value(12).value("ok").toBool(), "too many pixels");
+    check(byId.contains(13) && !byId.value(13).value("ok").toBool(), "no pixels");
+    check(byId.contains(14) && !byId.value(14).value("ok").toBool(), "non-integer number of pixels");
+    check(byId.contains(15) && !byId.value(15).value("ok").toBool()
+          && byId.value(15).value("error").toString() == "Altitude must be positive",
+          "zero altitude (error of orbitPixCalc())");
+    check(byId.contains(16) && !byId.value(16).value("ok").toBool(), "fov greater than the max allowed value");
+    check(byId.contains(17) && !byId.value(17).value("ok").toBool(), "unknown command");
+    check(byId.contains(19) && !byId.value(19).value("ok").toBool(), "negative radius");
+
+    // ... and the server keeps working
+    client_2.send(calcReq(18, 550, 0.3142, 0.2618, 6371, 640));
+    replies = client_2.receive(1);
+    check(replies.size() == 1 && replies[0].value("ok").toBool(), "the server works after the invalid requests");
+
+    printf("%d checks, %d failed\n", nChecks, nFailed);
+
+    return nFailed == 0 ? 0 : 1;
+}
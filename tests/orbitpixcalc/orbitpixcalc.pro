@@ -0,0 +1,24 @@
+#-------------------------------------------------
+#
+# Core calculation: parallel chunks against the serial loop
+#
+#-------------------------------------------------
+
+QT       += core
+QT       -= gui
+
+CONFIG += c++11 thread console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_orbitpixcalc
+TEMPLATE = app
+
+INCLUDEPATH += ../../src
+
+SOURCES += tst_orbitpixcalc.cpp \
+    ../../src/orbitpixcalc.cpp \
+    ../../src/demterrain.cpp
+
+HEADERS  += ../../src/orbitpixcalc.h \
+    ../../src/dualnum.h \
+    ../../src/demterrain.h
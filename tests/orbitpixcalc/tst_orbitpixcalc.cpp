@@ -0,0 +1,157 @@
+#include "orbitpixcalc.h"
+#include <stdio.h>
+#include <math.h>
+#include <thread>
+
+#define CHUNK 4096 // PAR_CHUNK of orbitpixcalc.cpp
+
+static int nChecks = 0, nFailed = 0;
+
+static void check(bool cond, const char *what)
+{
+    nChecks++;
+    if (!cond)
+    {
+        printf("FAIL: %s\n", what);
+        nFailed++;
+    }
+}
+
+// Same values, bit by bit (nan == nan)
+static bool sameVec(const vector<double> &a, const vector<double> &b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); i++)
+        if (a[i] != b[i] && !(isnan(a[i]) && isnan(b[i])))
+            return false;
+
+    return true;
+}
+
+static bool sameResult(const OrbitPixResult &a, const OrbitPixResult &b)
+{
+    return a.err == b.err && sameVec(a.angVec, b.angVec) && sameVec(a.losVec, b.losVec)
+           && sameVec(a.dAngSidesVec, b.dAngSidesVec) && sameVec(a.pixVec, b.pixVec)
+           && sameVec(a.alongPixVec, b.alongPixVec) && sameVec(a.grndVelVec, b.grndVelVec)
+           && sameVec(a.lineRateVec, b.lineRateVec) && sameVec(a.smearVec, b.smearVec);
+}
+
+// The chunked (parallel) calculation against the serial loop of the caller thread
+static bool sameAsSerial(OrbitPixInput in)
+{
+    OrbitPixResult chunked, serial;
+
+    in.maxThreads = 0;
+    chunked = orbitPixCalc(in);
+    in.maxThreads = 1;
+    serial = orbitPixCalc(in);
+
+    return chunked.err == ERR_NONE && chunked.losVec.size() == (size_t)in.px && sameResult(chunked, serial);
+}
+
+// The error of a configuration (and no results with an error)
+static OrbitPixErr calcErr(double h, double fov, double viewAng, double r, int px)
+{
+    OrbitPixResult res = orbitPixCalc(orbitPixInput(h, fov, viewAng, r, px), CALC_LOS | CALC_SIZE | CALC_SENS);
+
+    if (res.err != ERR_NONE && !(res.losVec.empty() && res.pixVec.empty() && res.losSensVec[SENS_H].empty()))
+        return ERR_NONE;
+
+    return res.err;
+}
+
+// tst_orbitpixcalc: checks the validation of the geometry, and that the parallel chunks give the same results as the
+// serial loop, also across the chunk boundaries and from many caller threads at the same time. Exits with 1 if a
+// check fails.
+int main()
+{
+    OrbitPixInput in;
+    DemTerrain dem;
+    vector<float> heights(20001);
+    OrbitPixResult ref, res;
+    bool same[4];
+    vector<thread> callers;
+
+    // Invalid geometry
+    check(calcErr(550, 0.3, 0.1, 6371, 640) == ERR_NONE, "valid configuration");
+    check(calcErr(0, 0.3, 0.1, 6371, 640) == ERR_H, "zero altitude");
+    check(calcErr(-550, 0.3, 0.1, 6371, 640) == ERR_H, "negative altitude");
+    check(calcErr(NAN, 0.3, 0.1, 6371, 640) == ERR_H, "nan altitude");
+    check(calcErr(INFINITY, 0.3, 0.1, 6371, 640) == ERR_H, "infinite altitude");
+    check(calcErr(550, 0.3, 0.1, 0, 640) == ERR_R, "zero radius");
+    check(calcErr(550, 0.3, 0.1, -6371, 640) == ERR_R, "negative radius");
+    check(calcErr(550, 0.3, 0.1, NAN, 640) == ERR_R, "nan radius");
+    check(calcErr(550, 0.3, 0.1, 6371, 0) == ERR_PX, "no pixels");
+    check(calcErr(550, 0, 0.1, 6371, 640) == ERR_FOV, "zero fov");
+    check(calcErr(550, -0.3, 0.1, 6371, 640) == ERR_FOV, "negative fov");
+    check(calcErr(550, NAN, 0.1, 6371, 640) == ERR_FOV, "nan fov");
+    check(calcErr(550, 3.0, 0.1, 6371, 640) == ERR_FOV, "fov greater than the max allowed value");
+    check(calcErr(550, 0.3, NAN, 6371, 640) == ERR_VIEW_ANG, "nan view angle");
+    check(calcErr(550, 0.3, -1.5, 6371, 640) == ERR_VIEW_ANG, "view angle greater than the max allowed value");
+    in = orbitPixInput(550, 0.3, 0.1, 6371, 640);
+    in.mu = 0;
+    check(orbitPixCalc(in).err == ERR_NONE, "the motion parameters are not checked without motion");
+    in.motion = true;
+    check(orbitPixCalc(in).err == ERR_MU, "zero gravitational parameter");
+    in.mu = MU_EARTH;
+    in.intTime = -0.001;
+    check(orbitPixCalc(in).err == ERR_INT_TIME, "negative integration time");
+
+    // Motion, known values: the centre pixel is at nadir, where the ground point moves at the orbital velocity
+    // scaled to the surface (7.062 km/s at 500 km over the Earth)
+    in = orbitPixInput(500, 0.01, 0, 6371, 101);
+    in.motion = true;
+    in.intTime = 0.001;
+    res = orbitPixCalc(in, CALC_LOS);
+    check(res.err == ERR_NONE && res.grndVelVec.size() == 101, "motion: one value per pixel");
+    if (res.grndVelVec.size() == 101)
+    {
+        check(fabs(res.grndVelVec[50] - 6371.0 / 6871 * sqrt(MU_EARTH / 6871)) < 1e-9
+              && fabs(res.grndVelVec[50] - 7.062) < 1e-3, "motion: ground velocity at nadir");
+        check(fabs(res.alongPixVec[50] - 2 * 500 * tan(0.01 / 101 / 2)) < 1e-12, "motion: along-track size at nadir");
+        same[0] = true;
+        for (int i = 0; i < 101; i++)
+            same[0] = same[0] && res.grndVelVec[i] < res.grndVelVec[50] + 1e-12
+                      && fabs(res.lineRateVec[i] - res.grndVelVec[i] / res.alongPixVec[i]) <= 1e-12 * res.lineRateVec[i]
+                      && fabs(res.smearVec[i] - res.lineRateVec[i] * 0.001) <= 1e-12 * res.smearVec[i];
+        check(same[0], "motion: line rate = ground velocity / along-track size, smear = line rate * integration time, "
+                       "max ground velocity at nadir");
+    }
+
+    // Smooth sphere: one pixel more than 16 chunks (the last chunk has a single pixel)
+    in = orbitPixInput(550, 0.3142, 0.2618, 6371, 16 * CHUNK + 1);
+    check(sameAsSerial(in), "sphere: chunked = serial");
+    in.motion = true;
+    in.intTime = 0.001;
+    check(sameAsSerial(in), "sphere with motion: chunked = serial");
+
+    // DEM (mountains every ~0.5 km): one pixel more than 3 chunks
+    for (size_t j = 0; j < heights.size(); j++)
+        heights[j] = (float)(4 * sin(j * 0.05) * sin(j * 0.0013));
+    check(dem.loadProfile(heights, -0.1, 0.2 / (heights.size() - 1)), "the DEM profile loads");
+    in = orbitPixInput(550, 0.1, 0.02, 6371, 3 * CHUNK + 1);
+    in.dem = &dem;
+    check(sameAsSerial(in), "DEM: chunked = serial");
+
+    // Many callers share the thread pool
+    in = orbitPixInput(550, 0.3142, 0.2618, 6371, 16 * CHUNK + 1);
+    in.maxThreads = 1;
+    ref = orbitPixCalc(in);
+    in.maxThreads = 0;
+    for (int t = 0; t < 4; t++)
+        callers.push_back(thread([&, t]() { same[t] = sameResult(orbitPixCalc(in), ref); }));
+    for (int t = 0; t < 4; t++)
+    {
+        callers[t].join();
+        check(same[t], "concurrent calculations: chunked = serial");
+    }
+
+    // Limited number of threads
+    in.maxThreads = 2;
+    check(sameResult(orbitPixCalc(in), ref), "two threads: chunked = serial");
+
+    printf("%d checks, %d failed\n", nChecks, nFailed);
+
+    return nFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,28 @@
+#-------------------------------------------------
+#
+# Sweep spec: ranges, units, reducers and errors of the spec files
+#
+#-------------------------------------------------
+
+QT       += core
+QT       -= gui
+
+CONFIG += c++11 thread console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_sweepspec
+TEMPLATE = app
+
+INCLUDEPATH += ../../src
+
+SOURCES += tst_sweepspec.cpp \
+    ../../src/sweepspec.cpp \
+    ../../src/orbitpixcalc.cpp \
+    ../../src/orbitpixparams.cpp \
+    ../../src/demterrain.cpp
+
+HEADERS  += ../../src/sweepspec.h \
+    ../../src/orbitpixcalc.h \
+    ../../src/orbitpixparams.h \
+    ../../src/dualnum.h \
+    ../../src/demterrain.h
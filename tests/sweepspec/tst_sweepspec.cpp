@@ -0,0 +1,152 @@
+#include "sweepspec.h"
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#define PI 3.141592653589793
+#define SPEC_FILE "tst_sweepspec.txt"
+
+static int nChecks = 0, nFailed = 0;
+
+static void check(bool cond, const char *what)
+{
+    nChecks++;
+    if (!cond)
+    {
+        printf("FAIL: %s\n", what);
+        nFailed++;
+    }
+}
+
+// Write a spec file, load it and run it. Returns the rows of the output (without the '\n'), or none if the spec
+// doesn't load (then errMsg is its error).
+static vector<string> runSpec(const char *spec, string *errMsg)
+{
+    SweepSpec sweep;
+    vector<string> rows;
+    char buf[1024];
+    FILE *f;
+    bool loaded;
+
+    f = fopen(SPEC_FILE, "w");
+    if (f == NULL)
+        return rows;
+    fputs(spec, f);
+    fclose(f);
+    loaded = sweep.load(SPEC_FILE);
+    remove(SPEC_FILE);
+    *errMsg = sweep.getErrMsg();
+    if (!loaded)
+        return rows;
+
+    f = tmpfile();
+    if (f == NULL)
+        return rows;
+    sweep.run(f);
+    rewind(f);
+    while (fgets(buf, sizeof(buf), f))
+    {
+        rows.push_back(buf);
+        if (!rows.back().empty() && rows.back()[rows.back().size() - 1] == '\n')
+            rows.back().erase(rows.back().size() - 1);
+    }
+    fclose(f);
+
+    return rows;
+}
+
+static string fmt(const char *format, double val)
+{
+    char buf[64];
+
+    snprintf(buf, sizeof(buf), format, val);
+
+    return string(buf);
+}
+
+// The error of a spec that must not load
+static string loadErr(const char *spec)
+{
+    string errMsg;
+
+    return runSpec(spec, &errMsg).empty() ? errMsg : "loaded";
+}
+
+// tst_sweepspec: checks the exact output rows of small sweeps (ranges, units, reducers, invalid configurations) and
+// the errors of invalid spec files. Exits with 1 if a check fails.
+int main()
+{
+    vector<string> rows;
+    string errMsg, row;
+    OrbitPixResult res;
+    double sum;
+    bool same;
+
+    // Range with the stop value, default units (deg) and all the reducers
+    rows = runSpec("h = 500:600:50\n"
+                   "fov = 10\n"
+                   "viewAng = 5 # deg\n"
+                   "r = 6371\n"
+                   "px = 5\n"
+                   "columns = h, size_min, size_max, size_mean, size_first, size_last, size_center\n", &errMsg);
+    check(rows.size() == 4, "range: a header and a row for each value, the stop value included");
+    if (rows.size() == 4)
+    {
+        check(rows[0] == "h\tsize_min\tsize_max\tsize_mean\tsize_first\tsize_last\tsize_center", "header");
+        same = true;
+        for (int k = 0; k < 3; k++)
+        {
+            res = orbitPixCalc(orbitPixInput(500 + k * 50, (PI / 180) * 10, (PI / 180) * 5, 6371, 5));
+            sum = res.pixVec[0];
+            for (int i = 1; i < 5; i++)
+                sum += res.pixVec[i];
+            row = fmt("%.15g", 500 + k * 50)
+                  + "\t" + fmt("%.2f", *min_element(res.pixVec.begin(), res.pixVec.end()) * 1000)
+                  + "\t" + fmt("%.2f", *max_element(res.pixVec.begin(), res.pixVec.end()) * 1000)
+                  + "\t" + fmt("%.2f", sum / 5 * 1000) + "\t" + fmt("%.2f", res.pixVec[0] * 1000)
+                  + "\t" + fmt("%.2f", res.pixVec[4] * 1000) + "\t" + fmt("%.2f", res.pixVec[2] * 1000);
+            same = same && rows[k + 1] == row;
+        }
+        check(same, "reducers: min, max, mean, first, last and center of the pixel sizes");
+    }
+
+    // Fractional steps keep the stop value, px changes fastest
+    rows = runSpec("h = 550\nfov = 10\nviewAng = -0.2:0.2:0.1\nr = 6371\npx = 1, 2\ncolumns = viewAng, px\n",
+                   &errMsg);
+    check(rows.size() == 11 && rows[1] == "-0.2\t1" && rows[2] == "-0.2\t2" && rows[5] == "0\t1"
+          && rows[10] == "0.2\t2", "fractional range and the order of the configurations");
+
+    // Units and csv format
+    rows = runSpec("h = 550\nfov = 0.2\nviewAng = 10\nr = 6371\npx = 3\nfovUnit = rad\nangUnit = grad\n"
+                   "format = csv\ncolumns = fov, viewAng, los_first\n", &errMsg);
+    res = orbitPixCalc(orbitPixInput(550, 0.2, (PI / 200) * 10, 6371, 3));
+    check(rows.size() == 2 && rows[0] == "fov,viewAng,los_first" && rows[1] == "0.2,10," + fmt("%.4f", res.losVec[0]),
+          "fov in rad, view angle in grad, csv");
+
+    // nan for the configurations out of the allowed range (the fov of 170 deg is beyond the horizon)
+    rows = runSpec("h = 550\nfov = 10, 170\nviewAng = 0\nr = 6371\npx = 3\ncolumns = fov, los_mean, size_max\n",
+                   &errMsg);
+    check(rows.size() == 3 && rows[1].find("nan") == string::npos && rows[2] == "170\tnan\tnan",
+          "nan for an invalid configuration");
+
+    // Errors of the spec file
+    check(loadErr("h = 550\nfov = 10\nviewAng = 0\nr = 6371\npx = 3\ncolumns = h, size_median\n")
+          == "Line 6: unknown column size_median", "unknown column");
+    check(loadErr("h = 550\nfoo = 1\n") == "Line 2: unknown key foo", "unknown key");
+    check(loadErr("h = 550\nh = 600\n") == "Line 2: h is given twice", "key given twice");
+    check(loadErr("h = 550\nfov = 10\nviewAng = 0\nr = 6371\n") == "Missing values of px", "missing parameter");
+    check(loadErr("h = 0:100:50\nfov = 10\nviewAng = 0\nr = 6371\npx = 3\n") == "The altitude must be positive",
+          "zero altitude");
+    check(loadErr("h = 550\nfov = 10\nviewAng = 0\nr = 6371, -1\npx = 3\n") == "The radius must be positive",
+          "negative radius");
+    check(loadErr("h = 550\nfov = 10\nviewAng = 0\nr = 6371\npx = 2.5\n")
+          == "The number of pixels must be a positive integer", "non-integer number of pixels");
+    check(loadErr("h = 550\nmu = 0\n") == "Line 2: invalid value of mu (must be positive)", "zero mu");
+    check(loadErr("h = 550\nintTime = -0.001\n") == "Line 2: invalid value of intTime (must not be negative)",
+          "negative integration time");
+    check(loadErr("h = 550\nfov = 10\nviewAng = 0\nr = 6371\npx = 3\nformat = xml\n")
+          == "Line 6: the format must be tsv or csv", "unknown format");
+
+    printf("%d checks, %d failed\n", nChecks, nFailed);
+
+    return nFailed == 0 ? 0 : 1;
+}
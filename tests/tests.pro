@@ -0,0 +1,13 @@
+#-------------------------------------------------
+#
+# Console tests (no GUI): qmake && make check
+#
+#-------------------------------------------------
+
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    accuracy \
+    calcserver \
+    orbitpixcalc \
+    sweepspec